@@ -0,0 +1,671 @@
+#include "astcache.hpp"
+#include "literals.hpp"
+#include "memstats.hpp"
+#include "resultcache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __unix__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace astcache {
+
+    namespace {
+        /* Kinds of node records, one per concrete node class */
+        enum class NodeKind : uint8_t {
+            Num, NumB, String, Bool, ID, BinOp, RelOp, Not, And, Or, Type, Cast, ExpList, Call, Statements,
+            Break, Continue, Return, If, While, VarDecl, Assign, Formal, Formals, FuncDecl, Funcs, COUNT
+        };
+
+        // Sections start at multiples of 8 bytes, so every record is aligned in the mapped file
+        constexpr size_t ALIGNMENT = 8;
+
+        std::string entryPath(const std::string &directory, uint64_t hash) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.ast", static_cast<unsigned long long>(hash));
+            return directory + "/" + name;
+        }
+
+        /* Serializes a tree into the sections of an entry */
+        class Writer : public Visitor {
+        private:
+            std::unordered_map<std::string, uint32_t> stringIndices;
+            // Spans of all nodes, decoded once instead of once per node
+            std::vector<locations::Span> spans = locations::table().decodeAll();
+
+            uint32_t string(const std::string &value) {
+                auto it = stringIndices.find(value);
+                if (it != stringIndices.end()) {
+                    return it->second;
+                }
+                auto index = static_cast<uint32_t>(strings.size());
+                strings.push_back(StringRecord{static_cast<uint32_t>(characters.size()),
+                                               static_cast<uint32_t>(value.size())});
+                characters += value;
+                stringIndices.emplace(value, index);
+                return index;
+            }
+
+            // Appends the record of the node followed by the subtrees of its present children
+            void emit(ast::Node &node, NodeKind kind, int detail, int32_t value,
+                      std::initializer_list<ast::Node *> children) {
+                size_t index = nodes.size();
+                const locations::Span &span = spans[node.location];
+                nodes.push_back(NodeRecord{static_cast<uint8_t>(kind), static_cast<uint8_t>(detail), 0, 0, value, 0,
+                                           span.firstLine, span.firstColumn, span.lastLine, span.lastColumn});
+                uint32_t count = 0;
+                for (ast::Node *child : children) {
+                    if (child) {
+                        child->accept(*this);
+                        count++;
+                    }
+                }
+                nodes[index].children = count;
+                nodes[index].size = static_cast<uint32_t>(nodes.size() - index);
+            }
+
+            template<typename T>
+            void emitList(ast::Node &node, NodeKind kind, const std::vector<std::shared_ptr<T>> &items) {
+                size_t index = nodes.size();
+                emit(node, kind, 0, 0, {});
+                for (const auto &item : items) {
+                    item->accept(*this);
+                }
+                nodes[index].children = static_cast<uint32_t>(items.size());
+                nodes[index].size = static_cast<uint32_t>(nodes.size() - index);
+            }
+
+        public:
+            std::vector<NodeRecord> nodes;
+            std::vector<StringRecord> strings;
+            std::string characters;
+            std::vector<uint32_t> functions;
+            // False if a function body was never parsed
+            bool complete = true;
+
+            void visit(ast::Num &node) override {
+                emit(node, NodeKind::Num, 0, node.value, {});
+            }
+
+            void visit(ast::NumB &node) override {
+                emit(node, NodeKind::NumB, 0, node.value, {});
+            }
+
+            void visit(ast::String &node) override {
+                emit(node, NodeKind::String, 0, static_cast<int32_t>(string(node.value())), {});
+            }
+
+            void visit(ast::Bool &node) override {
+                emit(node, NodeKind::Bool, 0, node.value, {});
+            }
+
+            void visit(ast::ID &node) override {
+                emit(node, NodeKind::ID, 0, static_cast<int32_t>(string(node.value)), {});
+            }
+
+            void visit(ast::BinOp &node) override {
+                emit(node, NodeKind::BinOp, node.op, 0, {node.left.get(), node.right.get()});
+            }
+
+            void visit(ast::RelOp &node) override {
+                emit(node, NodeKind::RelOp, node.op, 0, {node.left.get(), node.right.get()});
+            }
+
+            void visit(ast::Not &node) override {
+                emit(node, NodeKind::Not, 0, 0, {node.exp.get()});
+            }
+
+            void visit(ast::And &node) override {
+                emit(node, NodeKind::And, 0, 0, {node.left.get(), node.right.get()});
+            }
+
+            void visit(ast::Or &node) override {
+                emit(node, NodeKind::Or, 0, 0, {node.left.get(), node.right.get()});
+            }
+
+            void visit(ast::Type &node) override {
+                emit(node, NodeKind::Type, node.type, 0, {});
+            }
+
+            void visit(ast::Cast &node) override {
+                emit(node, NodeKind::Cast, 0, 0, {node.exp.get(), node.target_type.get()});
+            }
+
+            void visit(ast::ExpList &node) override {
+                emitList(node, NodeKind::ExpList, node.exps);
+            }
+
+            void visit(ast::Call &node) override {
+                emit(node, NodeKind::Call, 0, 0, {node.func_id.get(), node.args.get()});
+            }
+
+            void visit(ast::Statements &node) override {
+                emitList(node, NodeKind::Statements, node.statements);
+            }
+
+            void visit(ast::Break &node) override {
+                emit(node, NodeKind::Break, 0, 0, {});
+            }
+
+            void visit(ast::Continue &node) override {
+                emit(node, NodeKind::Continue, 0, 0, {});
+            }
+
+            void visit(ast::Return &node) override {
+                emit(node, NodeKind::Return, 0, 0, {node.exp.get()});
+            }
+
+            void visit(ast::If &node) override {
+                emit(node, NodeKind::If, 0, 0, {node.condition.get(), node.then.get(), node.otherwise.get()});
+            }
+
+            void visit(ast::While &node) override {
+                emit(node, NodeKind::While, 0, 0, {node.condition.get(), node.body.get()});
+            }
+
+            void visit(ast::VarDecl &node) override {
+                emit(node, NodeKind::VarDecl, 0, 0, {node.id.get(), node.type.get(), node.init_exp.get()});
+            }
+
+            void visit(ast::Assign &node) override {
+                emit(node, NodeKind::Assign, 0, 0, {node.id.get(), node.exp.get()});
+            }
+
+            void visit(ast::Formal &node) override {
+                emit(node, NodeKind::Formal, 0, 0, {node.id.get(), node.type.get()});
+            }
+
+            void visit(ast::Formals &node) override {
+                emitList(node, NodeKind::Formals, node.formals);
+            }
+
+            void visit(ast::FuncDecl &node) override {
+                functions.push_back(static_cast<uint32_t>(nodes.size()));
+                complete = complete && node.body;
+                emit(node, NodeKind::FuncDecl, 0, 0,
+                     {node.id.get(), node.return_type.get(), node.formals.get(), node.body.get()});
+            }
+
+            void visit(ast::Funcs &node) override {
+                emitList(node, NodeKind::Funcs, node.funcs);
+            }
+        };
+
+        /* A read-only view of an entry: mapped where the platform supports it, read into memory otherwise */
+        class Mapping {
+        private:
+#ifdef __unix__
+            void *address = MAP_FAILED;
+#else
+            std::string contents;
+#endif
+
+        public:
+            const char *data = nullptr;
+            size_t size = 0;
+
+            explicit Mapping(const std::string &path) {
+#ifdef __unix__
+                int fd = open(path.c_str(), O_RDONLY);
+                if (fd < 0) {
+                    return;
+                }
+                struct stat status{};
+                if (fstat(fd, &status) == 0 && status.st_size > 0) {
+                    address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (address != MAP_FAILED) {
+                        data = static_cast<const char *>(address);
+                        size = status.st_size;
+                    }
+                }
+                close(fd);
+#else
+                std::ifstream in(path, std::ios::binary);
+                contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                data = contents.data();
+                size = contents.size();
+#endif
+            }
+
+            ~Mapping() {
+#ifdef __unix__
+                if (address != MAP_FAILED) {
+                    munmap(address, size);
+                }
+#endif
+            }
+
+            Mapping(const Mapping &) = delete;
+
+            Mapping &operator=(const Mapping &) = delete;
+        };
+
+        /* Rebuilds nodes from the records of a mapped entry. Children are built before their parent, as the
+         * parser builds them, and every node records the span stored with it */
+        class Reader {
+        private:
+            const NodeRecord *nodes;
+            const StringRecord *strings;
+            const char *characters;
+            bool headersOnly;
+            // Index of the next record to read
+            uint32_t next = 0;
+
+            std::string_view string(int32_t index) const {
+                return {characters + strings[index].offset, strings[index].length};
+            }
+
+            // Publishes the span of the record, so the node built from it records it
+            static void restoreSpan(const NodeRecord &record) {
+                locations::current = {record.firstLine, record.firstColumn, record.lastLine, record.lastColumn};
+            }
+
+            const NodeRecord &take() {
+                return nodes[next++];
+            }
+
+            NodeKind peekKind() const {
+                return static_cast<NodeKind>(nodes[next].kind);
+            }
+
+        public:
+            Reader(const char *data, const Header &header, bool headersOnly)
+                    : nodes(reinterpret_cast<const NodeRecord *>(data + header.nodesOffset)),
+                      strings(reinterpret_cast<const StringRecord *>(data + header.stringsOffset)),
+                      characters(data + header.charactersOffset), headersOnly(headersOnly) {}
+
+            std::shared_ptr<ast::ID> id() {
+                const NodeRecord &record = take();
+                std::string_view name = string(record.value);
+                restoreSpan(record);
+                return std::make_shared<ast::ID>(name.data(), name.size());
+            }
+
+            std::shared_ptr<ast::Type> type() {
+                const NodeRecord &record = take();
+                restoreSpan(record);
+                return std::make_shared<ast::Type>(static_cast<ast::BuiltInType>(record.detail));
+            }
+
+            std::shared_ptr<ast::Call> call() {
+                const NodeRecord &record = take();
+                std::shared_ptr<ast::ID> func = id();
+                const NodeRecord &listRecord = take();
+                std::vector<std::shared_ptr<ast::Exp>> args;
+                for (uint32_t i = 0; i < listRecord.children; i++) {
+                    args.push_back(exp());
+                }
+                restoreSpan(listRecord);
+                auto list = std::make_shared<ast::ExpList>();
+                list->exps = std::move(args);
+                restoreSpan(record);
+                return std::make_shared<ast::Call>(func, list);
+            }
+
+            std::shared_ptr<ast::Exp> exp() {
+                if (peekKind() == NodeKind::Call) {
+                    return call();
+                }
+                if (peekKind() == NodeKind::ID) {
+                    return id();
+                }
+                const NodeRecord &record = take();
+                switch (static_cast<NodeKind>(record.kind)) {
+                    case NodeKind::Num:
+                        restoreSpan(record);
+                        return std::make_shared<ast::Num>(record.value);
+                    case NodeKind::NumB:
+                        restoreSpan(record);
+                        return std::make_shared<ast::NumB>(record.value);
+                    case NodeKind::String: {
+                        int index = literals::pool().add(string(record.value));
+                        restoreSpan(record);
+                        return std::make_shared<ast::String>(index);
+                    }
+                    case NodeKind::Bool:
+                        restoreSpan(record);
+                        return std::make_shared<ast::Bool>(record.value != 0);
+                    case NodeKind::Not: {
+                        std::shared_ptr<ast::Exp> operand = exp();
+                        restoreSpan(record);
+                        return std::make_shared<ast::Not>(operand);
+                    }
+                    case NodeKind::Cast: {
+                        std::shared_ptr<ast::Exp> operand = exp();
+                        std::shared_ptr<ast::Type> target = type();
+                        restoreSpan(record);
+                        return std::make_shared<ast::Cast>(operand, target);
+                    }
+                    default: {
+                        std::shared_ptr<ast::Exp> left = exp();
+                        std::shared_ptr<ast::Exp> right = exp();
+                        restoreSpan(record);
+                        switch (static_cast<NodeKind>(record.kind)) {
+                            case NodeKind::BinOp:
+                                return std::make_shared<ast::BinOp>(left, right,
+                                                                    static_cast<ast::BinOpType>(record.detail));
+                            case NodeKind::RelOp:
+                                return std::make_shared<ast::RelOp>(left, right,
+                                                                    static_cast<ast::RelOpType>(record.detail));
+                            case NodeKind::And:
+                                return std::make_shared<ast::And>(left, right);
+                            default:
+                                return std::make_shared<ast::Or>(left, right);
+                        }
+                    }
+                }
+            }
+
+            std::shared_ptr<ast::Statements> statements() {
+                const NodeRecord &record = take();
+                std::vector<std::shared_ptr<ast::Statement>> list;
+                list.reserve(record.children);
+                for (uint32_t i = 0; i < record.children; i++) {
+                    list.push_back(statement());
+                }
+                restoreSpan(record);
+                auto result = std::make_shared<ast::Statements>();
+                result->statements = std::move(list);
+                return result;
+            }
+
+            std::shared_ptr<ast::Statement> statement() {
+                switch (peekKind()) {
+                    case NodeKind::Statements:
+                        return statements();
+                    case NodeKind::Call:
+                        return call();
+                    default:
+                        break;
+                }
+                const NodeRecord &record = take();
+                switch (static_cast<NodeKind>(record.kind)) {
+                    case NodeKind::Break:
+                        restoreSpan(record);
+                        return std::make_shared<ast::Break>();
+                    case NodeKind::Continue:
+                        restoreSpan(record);
+                        return std::make_shared<ast::Continue>();
+                    case NodeKind::Return: {
+                        std::shared_ptr<ast::Exp> value = record.children ? exp() : nullptr;
+                        restoreSpan(record);
+                        return std::make_shared<ast::Return>(value);
+                    }
+                    case NodeKind::If: {
+                        std::shared_ptr<ast::Exp> condition = exp();
+                        std::shared_ptr<ast::Statement> then = statement();
+                        std::shared_ptr<ast::Statement> otherwise = record.children == 3 ? statement() : nullptr;
+                        restoreSpan(record);
+                        return std::make_shared<ast::If>(condition, then, otherwise);
+                    }
+                    case NodeKind::While: {
+                        std::shared_ptr<ast::Exp> condition = exp();
+                        std::shared_ptr<ast::Statement> body = statement();
+                        restoreSpan(record);
+                        return std::make_shared<ast::While>(condition, body);
+                    }
+                    case NodeKind::VarDecl: {
+                        std::shared_ptr<ast::ID> name = id();
+                        std::shared_ptr<ast::Type> varType = type();
+                        std::shared_ptr<ast::Exp> init = record.children == 3 ? exp() : nullptr;
+                        restoreSpan(record);
+                        return std::make_shared<ast::VarDecl>(name, varType, init);
+                    }
+                    default: {
+                        std::shared_ptr<ast::ID> name = id();
+                        std::shared_ptr<ast::Exp> value = exp();
+                        restoreSpan(record);
+                        return std::make_shared<ast::Assign>(name, value);
+                    }
+                }
+            }
+
+            std::shared_ptr<ast::Formals> formals() {
+                const NodeRecord &record = take();
+                auto list = std::vector<std::shared_ptr<ast::Formal>>();
+                for (uint32_t i = 0; i < record.children; i++) {
+                    const NodeRecord &formalRecord = take();
+                    std::shared_ptr<ast::ID> name = id();
+                    std::shared_ptr<ast::Type> paramType = type();
+                    restoreSpan(formalRecord);
+                    list.push_back(std::make_shared<ast::Formal>(name, paramType));
+                }
+                restoreSpan(record);
+                auto result = std::make_shared<ast::Formals>();
+                result->formals = std::move(list);
+                return result;
+            }
+
+            // The function whose record is at `index`
+            std::shared_ptr<ast::FuncDecl> funcDecl(uint32_t index) {
+                next = index;
+                const NodeRecord &record = take();
+                std::shared_ptr<ast::ID> name = id();
+                std::shared_ptr<ast::Type> returnType = type();
+                std::shared_ptr<ast::Formals> params = formals();
+                // With headersOnly the body's records are never visited
+                std::shared_ptr<ast::Statements> body = headersOnly ? nullptr : statements();
+                restoreSpan(record);
+                return std::make_shared<ast::FuncDecl>(name, returnType, params, body);
+            }
+
+            std::shared_ptr<ast::Funcs> program(const uint32_t *functions, uint32_t count) {
+                std::vector<std::shared_ptr<ast::FuncDecl>> funcs;
+                funcs.reserve(count);
+                for (uint32_t i = 0; i < count; i++) {
+                    funcs.push_back(funcDecl(functions[i]));
+                }
+                restoreSpan(nodes[0]);
+                auto result = std::make_shared<ast::Funcs>();
+                result->funcs = std::move(funcs);
+                return result;
+            }
+        };
+
+        /* Children a record of each kind takes, in NodeKind order: one category per child, with a trailing '?'
+         * making the last child optional, or a category followed by '*' for lists. Categories: e expression,
+         * s statement, i ID, t Type, l ExpList, f Formal, F Formals, b Statements, d FuncDecl */
+        const char *const SHAPES[] = {
+                "", "", "", "", "", "ee", "ee", "e", "ee", "ee", "", "et", "e*", "il", "s*",
+                "", "", "e?", "ess?", "es", "ite?", "ie", "it", "f*", "itFb", "d*"
+        };
+        static_assert(sizeof(SHAPES) / sizeof(SHAPES[0]) == static_cast<size_t>(NodeKind::COUNT),
+                      "one shape per node kind");
+
+        bool inCategory(char category, NodeKind kind) {
+            switch (category) {
+                case 'e':
+                    return kind <= NodeKind::Or || kind == NodeKind::Cast || kind == NodeKind::Call;
+                case 's':
+                    return (kind >= NodeKind::Statements && kind <= NodeKind::Assign) || kind == NodeKind::Call;
+                case 'i':
+                    return kind == NodeKind::ID;
+                case 't':
+                    return kind == NodeKind::Type;
+                case 'l':
+                    return kind == NodeKind::ExpList;
+                case 'f':
+                    return kind == NodeKind::Formal;
+                case 'F':
+                    return kind == NodeKind::Formals;
+                case 'b':
+                    return kind == NodeKind::Statements;
+                default:
+                    return kind == NodeKind::FuncDecl;
+            }
+        }
+
+        // Checks the children of the record against its shape, and that their subtrees exactly fill its own
+        bool shapeFits(const NodeRecord *nodes, uint32_t index) {
+            const NodeRecord &record = nodes[index];
+            const char *shape = SHAPES[record.kind];
+            size_t length = std::strlen(shape);
+            bool list = length == 2 && shape[1] == '*';
+            bool optional = length > 0 && shape[length - 1] == '?';
+            if (!list && (record.children > (optional ? length - 1 : length) ||
+                          record.children < (optional ? length - 2 : length))) {
+                return false;
+            }
+            uint32_t end = index + record.size;
+            uint32_t child = index + 1;
+            for (uint32_t i = 0; i < record.children; i++) {
+                if (child >= end || !inCategory(list ? shape[0] : shape[i], static_cast<NodeKind>(nodes[child].kind))) {
+                    return false;
+                }
+                child += nodes[child].size;
+            }
+            return child == end;
+        }
+
+        bool detailFits(const NodeRecord &record) {
+            switch (static_cast<NodeKind>(record.kind)) {
+                case NodeKind::BinOp:
+                    return record.detail <= ast::BinOpType::DIV;
+                case NodeKind::RelOp:
+                    return record.detail <= ast::RelOpType::GE;
+                case NodeKind::Type:
+                    return record.detail <= ast::BuiltInType::STRING;
+                default:
+                    return true;
+            }
+        }
+
+        bool sectionFits(size_t fileSize, uint32_t offset, uint64_t count, size_t recordSize) {
+            return offset % ALIGNMENT == 0 && offset <= fileSize && count * recordSize <= fileSize - offset;
+        }
+
+        // Checks that the entry belongs to the source and that every record is well formed, so a stale or
+        // damaged entry is treated as a miss
+        bool validate(const Mapping &mapping, std::string_view source) {
+            if (mapping.size < sizeof(Header)) {
+                return false;
+            }
+            const auto &header = *reinterpret_cast<const Header *>(mapping.data);
+            if (std::memcmp(header.magic, "FAST", 4) != 0 || header.version != FORMAT_VERSION ||
+                header.sourceHash != hashSource(source) || header.sourceLength != source.size() ||
+                header.nodeCount == 0 ||
+                !sectionFits(mapping.size, header.nodesOffset, header.nodeCount, sizeof(NodeRecord)) ||
+                !sectionFits(mapping.size, header.stringsOffset, header.stringCount, sizeof(StringRecord)) ||
+                !sectionFits(mapping.size, header.functionsOffset, header.functionCount, sizeof(uint32_t)) ||
+                header.charactersOffset > mapping.size ||
+                header.charactersLength > mapping.size - header.charactersOffset ||
+                header.sourceOffset > mapping.size || header.sourceLength > mapping.size - header.sourceOffset ||
+                std::memcmp(mapping.data + header.sourceOffset, source.data(), source.size()) != 0) {
+                return false;
+            }
+            const auto *strings = reinterpret_cast<const StringRecord *>(mapping.data + header.stringsOffset);
+            for (uint32_t i = 0; i < header.stringCount; i++) {
+                if (strings[i].offset > header.charactersLength ||
+                    strings[i].length > header.charactersLength - strings[i].offset) {
+                    return false;
+                }
+            }
+            const auto *nodes = reinterpret_cast<const NodeRecord *>(mapping.data + header.nodesOffset);
+            if (nodes[0].kind != static_cast<uint8_t>(NodeKind::Funcs) || nodes[0].size != header.nodeCount) {
+                return false;
+            }
+            for (uint32_t i = 0; i < header.nodeCount; i++) {
+                const NodeRecord &record = nodes[i];
+                bool named = record.kind == static_cast<uint8_t>(NodeKind::ID) ||
+                             record.kind == static_cast<uint8_t>(NodeKind::String);
+                if (record.kind >= static_cast<uint8_t>(NodeKind::COUNT) || record.size == 0 ||
+                    record.size > header.nodeCount - i || !detailFits(record) ||
+                    (named && (record.value < 0 || static_cast<uint32_t>(record.value) >= header.stringCount))) {
+                    return false;
+                }
+            }
+            // Kinds are all valid now, so shapes can be looked up
+            for (uint32_t i = 0; i < header.nodeCount; i++) {
+                if (!shapeFits(nodes, i)) {
+                    return false;
+                }
+            }
+            // The function index lists exactly the children of the root
+            const auto *functions = reinterpret_cast<const uint32_t *>(mapping.data + header.functionsOffset);
+            if (header.functionCount != nodes[0].children) {
+                return false;
+            }
+            uint32_t child = 1;
+            for (uint32_t i = 0; i < header.functionCount; i++) {
+                if (functions[i] != child) {
+                    return false;
+                }
+                child += nodes[child].size;
+            }
+            return true;
+        }
+
+        // Pads the entry with zeros up to the next section boundary and returns the offset reached
+        uint32_t align(std::string &entry) {
+            entry.resize((entry.size() + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT, '\0');
+            return static_cast<uint32_t>(entry.size());
+        }
+
+        template<typename T>
+        uint32_t appendSection(std::string &entry, const std::vector<T> &records) {
+            uint32_t offset = align(entry);
+            entry.append(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(T));
+            return offset;
+        }
+    }
+
+    uint64_t hashSource(std::string_view source) {
+        uint64_t hash = 14695981039346656037ull;
+        for (char c : source) {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::shared_ptr<ast::Funcs> load(const std::string &directory, std::string_view source, bool headersOnly) {
+        Mapping mapping(entryPath(directory, hashSource(source)));
+        if (!mapping.data || !validate(mapping, source)) {
+            return nullptr;
+        }
+        memstats::TagScope tag(memstats::AST);
+        const auto &header = *reinterpret_cast<const Header *>(mapping.data);
+        Reader reader(mapping.data, header, headersOnly);
+        return reader.program(reinterpret_cast<const uint32_t *>(mapping.data + header.functionsOffset),
+                              header.functionCount);
+    }
+
+    bool store(const std::string &directory, std::string_view source, ast::Funcs &program) {
+        Writer writer;
+        program.accept(writer);
+        if (!writer.complete) {
+            return false;
+        }
+
+        Header header{};
+        std::memcpy(header.magic, "FAST", 4);
+        header.version = FORMAT_VERSION;
+        header.sourceHash = hashSource(source);
+        header.sourceLength = source.size();
+        header.nodeCount = static_cast<uint32_t>(writer.nodes.size());
+        header.stringCount = static_cast<uint32_t>(writer.strings.size());
+        header.charactersLength = static_cast<uint32_t>(writer.characters.size());
+        header.functionCount = static_cast<uint32_t>(writer.functions.size());
+
+        std::string entry(sizeof(Header), '\0');
+        header.nodesOffset = appendSection(entry, writer.nodes);
+        header.stringsOffset = appendSection(entry, writer.strings);
+        header.functionsOffset = appendSection(entry, writer.functions);
+        header.charactersOffset = align(entry);
+        entry += writer.characters;
+        header.sourceOffset = entry.size();
+        entry += source;
+        std::memcpy(&entry[0], &header, sizeof(Header));
+
+        // Never truncated in place, since a concurrent run may have the entry mapped
+        return resultcache::writeAtomically(entryPath(directory, header.sourceHash), entry);
+    }
+}
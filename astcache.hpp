@@ -0,0 +1,79 @@
+#ifndef ASTCACHE_HPP
+#define ASTCACHE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "nodes.hpp"
+
+/* On-disk cache of checked syntax trees, keyed by a hash of the source. An entry is a single file that is
+ * mapped into memory as is: it holds no pointers, only offsets from the start of the file, so it needs no
+ * fixups when loaded. It also holds a copy of the source, compared byte for byte on load, so a source whose
+ * hash collides with another's never loads the other tree. A cache hit replaces scanning and parsing with one
+ * comparison and one linear pass over the node records */
+namespace astcache {
+
+    // Changed whenever the layout of an entry changes; entries of other versions are ignored
+    constexpr uint32_t FORMAT_VERSION = 2;
+
+    /* Start of an entry. Every section is an array of fixed-size records at the given offset */
+    struct Header {
+        // "FAST"
+        char magic[4];
+        uint32_t version;
+        // Hash of the source the tree was parsed from, and the source itself, compared with the one being compiled
+        uint64_t sourceHash;
+        uint64_t sourceLength;
+        uint64_t sourceOffset;
+        // NodeRecord array, the tree in preorder
+        uint32_t nodeCount;
+        uint32_t nodesOffset;
+        // StringRecord array, and the characters they point into
+        uint32_t stringCount;
+        uint32_t stringsOffset;
+        uint32_t charactersOffset;
+        uint32_t charactersLength;
+        // Index of the record of every FuncDecl, in order
+        uint32_t functionCount;
+        uint32_t functionsOffset;
+    };
+
+    /* A node. Its children follow it in preorder, in the order of their constructor's arguments */
+    struct NodeRecord {
+        // NodeKind
+        uint8_t kind;
+        // Operator of BinOp and RelOp, type of Type
+        uint8_t detail;
+        uint16_t reserved;
+        // Number of direct children; optional children (Return, If, VarDecl, Call) are simply absent
+        uint32_t children;
+        // Value of Num, NumB and Bool; string index of ID and String
+        int32_t value;
+        // Number of records in the subtree, this one included, so whole subtrees can be skipped
+        uint32_t size;
+        int32_t firstLine;
+        int32_t firstColumn;
+        int32_t lastLine;
+        int32_t lastColumn;
+    };
+
+    /* An identifier or a decoded string literal */
+    struct StringRecord {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    // FNV-1a hash of the source, the key of its entry
+    uint64_t hashSource(std::string_view source);
+
+    // Loads the tree of the source from the cache in `directory`, or returns nullptr if there is no valid
+    // entry. With headersOnly, only the function headers are loaded and the bodies are left empty
+    std::shared_ptr<ast::Funcs> load(const std::string &directory, std::string_view source, bool headersOnly);
+
+    // Writes the tree of the source to the cache in `directory`. Returns false if the entry could not be
+    // written or the tree has unparsed bodies
+    bool store(const std::string &directory, std::string_view source, ast::Funcs &program);
+}
+
+#endif //ASTCACHE_HPP
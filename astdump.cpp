@@ -0,0 +1,191 @@
+#include "astdump.hpp"
+#include "types.hpp"
+#include <string>
+
+namespace astdump {
+
+    namespace {
+        const char *const BINOP_NAMES[] = {"+", "-", "*", "/"};
+        const char *const RELOP_NAMES[] = {"==", "!=", "<", ">", "<=", ">="};
+
+        /* Prints every node as it is entered, then its children one level deeper */
+        class Printer : public Visitor {
+        private:
+            std::ostream &os;
+            int depth = 0;
+
+            // Prints the indentation, kind, detail and span of the node
+            void line(const ast::Node &node, const char *kind, const std::string &detail = "") {
+                locations::Span span = node.span();
+                os << std::string(2 * depth, ' ') << kind;
+                if (!detail.empty()) {
+                    os << " " << detail;
+                }
+                os << " " << span.firstLine << ":" << span.firstColumn << "-" << span.lastLine << ":"
+                   << span.lastColumn << "\n";
+            }
+
+            // Prints the child one level deeper, or nothing if it is absent
+            void child(const std::shared_ptr<ast::Node> &node) {
+                if (node) {
+                    depth++;
+                    node->accept(*this);
+                    depth--;
+                }
+            }
+
+            template<typename T>
+            void children(const std::vector<std::shared_ptr<T>> &nodes) {
+                for (const auto &node : nodes) {
+                    child(node);
+                }
+            }
+
+        public:
+            explicit Printer(std::ostream &os) : os(os) {}
+
+            void visit(ast::Num &node) override {
+                line(node, "Num", std::to_string(node.value));
+            }
+
+            void visit(ast::NumB &node) override {
+                line(node, "NumB", std::to_string(node.value));
+            }
+
+            void visit(ast::String &node) override {
+                line(node, "String", node.value());
+            }
+
+            void visit(ast::Bool &node) override {
+                line(node, "Bool", node.value ? "true" : "false");
+            }
+
+            void visit(ast::ID &node) override {
+                line(node, "ID", node.value);
+            }
+
+            void visit(ast::BinOp &node) override {
+                line(node, "BinOp", BINOP_NAMES[node.op]);
+                child(node.left);
+                child(node.right);
+            }
+
+            void visit(ast::RelOp &node) override {
+                line(node, "RelOp", RELOP_NAMES[node.op]);
+                child(node.left);
+                child(node.right);
+            }
+
+            void visit(ast::Not &node) override {
+                line(node, "Not");
+                child(node.exp);
+            }
+
+            void visit(ast::And &node) override {
+                line(node, "And");
+                child(node.left);
+                child(node.right);
+            }
+
+            void visit(ast::Or &node) override {
+                line(node, "Or");
+                child(node.left);
+                child(node.right);
+            }
+
+            void visit(ast::Type &node) override {
+                line(node, "Type", types::name(node.type));
+            }
+
+            void visit(ast::Cast &node) override {
+                line(node, "Cast");
+                child(node.target_type);
+                child(node.exp);
+            }
+
+            void visit(ast::ExpList &node) override {
+                line(node, "ExpList");
+                children(node.exps);
+            }
+
+            void visit(ast::Call &node) override {
+                line(node, "Call");
+                child(node.func_id);
+                child(node.args);
+            }
+
+            void visit(ast::Statements &node) override {
+                line(node, "Statements");
+                children(node.statements);
+            }
+
+            void visit(ast::Break &node) override {
+                line(node, "Break");
+            }
+
+            void visit(ast::Continue &node) override {
+                line(node, "Continue");
+            }
+
+            void visit(ast::Return &node) override {
+                line(node, "Return");
+                child(node.exp);
+            }
+
+            void visit(ast::If &node) override {
+                line(node, "If");
+                child(node.condition);
+                child(node.then);
+                child(node.otherwise);
+            }
+
+            void visit(ast::While &node) override {
+                line(node, "While");
+                child(node.condition);
+                child(node.body);
+            }
+
+            void visit(ast::VarDecl &node) override {
+                line(node, "VarDecl");
+                child(node.type);
+                child(node.id);
+                child(node.init_exp);
+            }
+
+            void visit(ast::Assign &node) override {
+                line(node, "Assign");
+                child(node.id);
+                child(node.exp);
+            }
+
+            void visit(ast::Formal &node) override {
+                line(node, "Formal");
+                child(node.type);
+                child(node.id);
+            }
+
+            void visit(ast::Formals &node) override {
+                line(node, "Formals");
+                children(node.formals);
+            }
+
+            void visit(ast::FuncDecl &node) override {
+                line(node, "FuncDecl");
+                child(node.return_type);
+                child(node.id);
+                child(node.formals);
+                child(node.body);
+            }
+
+            void visit(ast::Funcs &node) override {
+                line(node, "Funcs");
+                children(node.funcs);
+            }
+        };
+    }
+
+    void dump(ast::Node &root, std::ostream &os) {
+        Printer printer(os);
+        root.accept(printer);
+    }
+}
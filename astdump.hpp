@@ -0,0 +1,14 @@
+#ifndef ASTDUMP_HPP
+#define ASTDUMP_HPP
+
+#include <ostream>
+#include "nodes.hpp"
+
+namespace astdump {
+
+    // Prints the tree rooted at the node, one node per line indented by depth: its kind, its value
+    // or operator, and its source span
+    void dump(ast::Node &root, std::ostream &os);
+}
+
+#endif //ASTDUMP_HPP
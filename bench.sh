@@ -0,0 +1,240 @@
+#!/bin/bash
+# Generates large synthetic FanC inputs and times ./hw3 on them.
+# Usage: ./bench.sh <case> [size]
+# Set PERF=1 to also read hardware performance counters per phase.
+
+gen_exprs() {
+    # One function with $1 statements repeating the same subexpressions
+    echo "int f(int a, int b) {"
+    echo "    int x = 0;"
+    for ((i = 0; i < $1; i++)); do
+        echo "    x = x + (a * b + $i) * (a * b + $i) - (b * a + $i);"
+    done
+    echo "    return x;"
+    echo "}"
+    echo "void main() { printi(f(1, 2)); }"
+}
+
+gen_cfg() {
+    # One function with $1 statements mixing ifs, loops, breaks and returns
+    echo "void main() {"
+    echo "    int x = 0;"
+    for ((i = 0; i < $1; i++)); do
+        echo "    while (x < $i) {"
+        echo "        if (x == $i) { x = x + 1; break; } else { x = x - 1; continue; }"
+        echo "        x = x * 2;"
+        echo "    }"
+    done
+    echo "    return;"
+    echo "}"
+}
+
+gen_nested() {
+    # $1 sequential nests of blocks, ifs and loops, each declaring variables at every level
+    echo "void main() {"
+    for ((i = 0; i < $1; i++)); do
+        echo "    {"
+        echo "        int a = $i;"
+        echo "        if (a > 0) {"
+        echo "            int b = a;"
+        echo "            while (b > 0) { int c = b; b = c - 1; { int d = c; } }"
+        echo "        }"
+        echo "    }"
+    done
+    echo "}"
+}
+
+gen_literals() {
+    # One function with $1 statements made mostly of numeric literals
+    echo "void main() {"
+    echo "    int x = 0;"
+    echo "    byte y = 0b;"
+    for ((i = 0; i < $1; i++)); do
+        echo "    x = 1234567 + $i * 98765 - 2147483 + 31415926 * 2;"
+        echo "    y = 17b + $((i % 200))b;"
+    done
+    echo "}"
+}
+
+gen_tokens() {
+    # One function with $1 lines of declarations, calls, comments and string literals
+    echo "void main() {"
+    for ((i = 0; i < $1; i++)); do
+        echo "    int value$i = (counter * 31 + $i) / 7; // keep the scanner busy with a comment"
+        echo "    print(\"line $i of the generated program\");"
+    done
+    echo "}"
+}
+
+gen_funcs() {
+    # $1 functions with signatures and loop-heavy bodies
+    for ((i = 0; i < $1; i++)); do
+        echo "int f$i(int a, byte b, bool c) {"
+        echo "    int x = a;"
+        echo "    while (x < a * 10 and c) { if (x == b) { x = x + 2; } else { x = x + 1; } }"
+        echo "    return x;"
+        echo "}"
+    done
+    echo "void main() { printi(f0(1, 2b, true)); }"
+}
+
+gen_unit() {
+    # Unit $2 of $3 of the program of gen_funcs $1, taking every $3-th function; main is in unit 0
+    gen_funcs "$1" | awk -v unit="$2" -v units="$3" '
+        /^int f/ { n++ }
+        /^void main/ { if (unit == 0) print; next }
+        (n - 1) % units == unit'
+}
+
+now_us() {
+    echo $(($(date +%s%N) / 1000))
+}
+
+case_name="$1"
+size="${2:-10000}"
+input="bench_${case_name}.in"
+
+case "$case_name" in
+    cfg)
+        gen_cfg "$size" > "$input"
+        flags="--dump-cfg --time-passes"
+        ;;
+    dataflow)
+        gen_cfg "$size" > "$input"
+        flags="-Wall --time-passes"
+        ;;
+    optimize)
+        gen_exprs "$size" > "$input"
+        flags="-O2 --time-passes"
+        ;;
+    scopes)
+        gen_nested "$size" > "$input"
+        flags="--time-passes"
+        ;;
+    literals)
+        gen_literals "$size" > "$input"
+        flags="--time-passes"
+        ;;
+    lexer)
+        # Scanning throughput in bytes/s of both scanners
+        gen_tokens "$size" > "$input"
+        echo "Case ${case_name}, size ${size}, $(wc -c < "$input") bytes"
+        for lexer in flex simd; do
+            ./hw3 --lexer="$lexer" --dump-tokens --time-passes < "$input" 2>&1 > /dev/null | grep "^lex:" |
+                sed "s/^lex:/${lexer}:/"
+        done
+        rm -f "$input"
+        exit 0
+        ;;
+    parser)
+        # Parse time of the bison and the hand-written parser on expression-heavy input
+        gen_exprs "$size" > "$input"
+        echo "Case ${case_name}, size ${size}, $(wc -c < "$input") bytes"
+        for parser in bison pratt; do
+            ./hw3 --parser="$parser" --dump-ast --time-passes < "$input" 2>&1 > /dev/null | grep "^parse:" |
+                sed "s/^parse:/${parser}:/"
+        done
+        rm -f "$input"
+        exit 0
+        ;;
+    signatures)
+        # Parse time of a full parse against parsing function headers only
+        gen_funcs "$size" > "$input"
+        echo "Case ${case_name}, size ${size}, $(wc -c < "$input") bytes"
+        ./hw3 --parser=pratt --dump-ast --time-passes < "$input" 2>&1 > /dev/null | grep "^parse:" |
+            sed "s/^parse:/full:/"
+        ./hw3 --signatures --time-passes < "$input" 2>&1 > /dev/null | grep "^parse:" | sed "s/^parse:/headers:/"
+        rm -f "$input"
+        exit 0
+        ;;
+    ast-cache)
+        # Front-end time of a cold run, which scans, parses and stores the tree, against a warm run loading it
+        # and a warm run loading only the function headers
+        gen_funcs "$size" > "$input"
+        echo "Case ${case_name}, size ${size}, $(wc -c < "$input") bytes"
+        rm -rf bench_cache && mkdir bench_cache
+        for run in cold warm; do
+            echo "${run}:"
+            ./hw3 --ast-cache=bench_cache --time-passes < "$input" 2>&1 > /dev/null | grep -E "^(ast-cache|lex|parse):" |
+                sed "s/^/    /"
+        done
+        echo "headers:"
+        ./hw3 --signatures --ast-cache=bench_cache --time-passes < "$input" 2>&1 > /dev/null | grep "^ast-cache:" |
+            sed "s/^/    /"
+        rm -rf "$input" bench_cache
+        exit 0
+        ;;
+    result-cache)
+        # Wall time of a cold run, which compiles and stores the output, against a warm run replaying it
+        gen_funcs "$size" > "$input"
+        echo "Case ${case_name}, size ${size}, $(wc -c < "$input") bytes"
+        rm -rf bench_cache
+        for run in cold warm; do
+            start=$(now_us)
+            ./hw3 --result-cache=bench_cache < "$input" > /dev/null
+            echo "${run}: $(($(now_us) - start)) us"
+        done
+        rm -rf "$input" bench_cache
+        exit 0
+        ;;
+    modules)
+        # Wall time of checking one program whole against splitting it into units checked in parallel, each
+        # importing the interfaces of the others
+        units=4
+        gen_funcs "$size" > "$input"
+        echo "Case ${case_name}, size ${size}, $(wc -c < "$input") bytes, ${units} units"
+        start=$(now_us)
+        ./hw3 < "$input" > /dev/null
+        echo "whole: $(($(now_us) - start)) us"
+        for ((unit = 0; unit < units; unit++)); do
+            gen_unit "$size" "$unit" "$units" > "bench_unit${unit}.in"
+        done
+        start=$(now_us)
+        for ((unit = 0; unit < units; unit++)); do
+            ./hw3 --emit-interface="bench_unit${unit}.fi" < "bench_unit${unit}.in" &
+        done
+        wait
+        echo "interfaces: $(($(now_us) - start)) us"
+        start=$(now_us)
+        for ((unit = 0; unit < units; unit++)); do
+            imports=()
+            for ((other = 0; other < units; other++)); do
+                if ((other != unit)); then
+                    imports+=("--import=bench_unit${other}.fi")
+                fi
+            done
+            ./hw3 "${imports[@]}" < "bench_unit${unit}.in" > /dev/null &
+        done
+        wait
+        echo "units: $(($(now_us) - start)) us"
+        rm -f "$input" bench_unit*
+        exit 0
+        ;;
+    positions)
+        # Semantic pass time without and with the position index, then the time to answer queries spread over the input
+        gen_funcs "$size" > "$input"
+        echo "Case ${case_name}, size ${size}, $(wc -c < "$input") bytes"
+        queries=()
+        for ((i = 0; i < 100; i++)); do
+            line=$((i * size / 100 * 5 + 2))
+            queries+=("--query=type:${line}:9" "--query=references:${line}:9")
+        done
+        echo "Without index:"
+        ./hw3 --time-passes < "$input" 2>&1 > /dev/null | grep -E "semantic"
+        echo "With index:"
+        ./hw3 --time-passes "${queries[@]}" < "$input" 2>&1 > /dev/null | grep -E "semantic|^query:"
+        rm -f "$input"
+        exit 0
+        ;;
+    *)
+        echo "Usage: $0 {cfg|dataflow|optimize|scopes|literals|lexer|parser|signatures|ast-cache|result-cache|modules|positions} [size]"
+        exit 1
+        ;;
+esac
+
+echo "Case ${case_name}, size ${size}, $(wc -c < "$input") bytes"
+if [ -n "$PERF" ]; then
+    flags="$flags --perf-counters"
+fi
+time ./hw3 $flags < "$input" > /dev/null
+rm -f "$input"
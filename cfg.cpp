@@ -0,0 +1,441 @@
+#include "cfg.hpp"
+
+namespace cfg {
+
+    /* Helper functions */
+
+    static const char *kindName(InstrKind kind) {
+        switch (kind) {
+            case InstrKind::VarDecl:
+                return "VarDecl";
+            case InstrKind::Assign:
+                return "Assign";
+            case InstrKind::Call:
+                return "Call";
+            case InstrKind::Return:
+                return "Return";
+            case InstrKind::Branch:
+                return "Branch";
+            default:
+                return "Unknown";
+        }
+    }
+
+    static std::string slotName(const FunctionCFG &graph, int slot) {
+        return graph.locals[slot].name + "#" + std::to_string(slot);
+    }
+
+    // Writes "Kind def <- uses" for one instruction
+    static void describe(const FunctionCFG &graph, const Instr &instr, std::ostream &os) {
+        os << "line " << instr.node->line() << ": " << kindName(instr.kind);
+        if (instr.def >= 0) {
+            os << " " << slotName(graph, instr.def);
+        }
+        if (instr.numUses > 0) {
+            os << " <-";
+            for (const int *use = graph.usesBegin(instr); use != graph.usesEnd(instr); ++use) {
+                os << " " << slotName(graph, *use);
+            }
+        }
+    }
+
+    /* FunctionCFG implementation */
+
+    void FunctionCFG::dumpText(std::ostream &os) const {
+        os << "function " << name << std::endl;
+        for (int b = 0; b < numBlocks(); ++b) {
+            os << "bb" << b;
+            if (b == ENTRY) {
+                os << " (entry)";
+            } else if (b == EXIT) {
+                os << " (exit)";
+            } else if (!blocks[b].reachable) {
+                os << " (unreachable)";
+            }
+            os << ":" << std::endl;
+
+            for (const Instr *instr = instrsBegin(b); instr != instrsEnd(b); ++instr) {
+                os << "  ";
+                describe(*this, *instr, os);
+                os << std::endl;
+            }
+
+            if (blocks[b].numSuccs > 0) {
+                os << "  ->";
+                for (const int *succ = succsBegin(b); succ != succsEnd(b); ++succ) {
+                    os << " bb" << *succ;
+                }
+                os << std::endl;
+            }
+        }
+    }
+
+    void FunctionCFG::dumpDot(std::ostream &os) const {
+        os << "digraph \"" << name << "\" {" << std::endl;
+        os << "  node [shape=box, fontname=monospace];" << std::endl;
+        for (int b = 0; b < numBlocks(); ++b) {
+            os << "  bb" << b << " [label=\"bb" << b << "\\l";
+            for (const Instr *instr = instrsBegin(b); instr != instrsEnd(b); ++instr) {
+                describe(*this, *instr, os);
+                os << "\\l";
+            }
+            os << "\"";
+            if (!blocks[b].reachable) {
+                os << ", style=dashed";
+            }
+            os << "];" << std::endl;
+        }
+        for (int b = 0; b < numBlocks(); ++b) {
+            bool branch = blocks[b].numInstrs > 0 && instrsEnd(b)[-1].kind == InstrKind::Branch;
+            for (const int *succ = succsBegin(b); succ != succsEnd(b); ++succ) {
+                os << "  bb" << b << " -> bb" << *succ;
+                if (branch) {
+                    os << " [label=\"" << (succ == succsBegin(b) ? "T" : "F") << "\"]";
+                }
+                os << ";" << std::endl;
+            }
+        }
+        os << "}" << std::endl;
+    }
+
+    /* CFGBuilder implementation */
+
+    int CFGBuilder::newBlock() {
+        cfg->blocks.push_back(BasicBlock{0, 0, 0, 0, 0, 0, false});
+        return cfg->numBlocks() - 1;
+    }
+
+    void CFGBuilder::addEdge(int from, int to) {
+        edges.emplace_back(from, to);
+    }
+
+    void CFGBuilder::addInstr(ast::Node *node, InstrKind kind, int def) {
+        int firstUse = static_cast<int>(cfg->uses.size());
+        cfg->uses.insert(cfg->uses.end(), currentUses.begin(), currentUses.end());
+        pendingInstrs.push_back(Instr{node, kind, def, firstUse, static_cast<int>(currentUses.size())});
+        pendingBlocks.push_back(current);
+        currentUses.clear();
+    }
+
+    void CFGBuilder::beginScope() {
+        scopeMarks.emplace_back(names.size(), nextOffset);
+    }
+
+    void CFGBuilder::endScope() {
+        names.resize(scopeMarks.back().first);
+        nextOffset = scopeMarks.back().second;
+        scopeMarks.pop_back();
+    }
+
+    int CFGBuilder::declare(const std::string &name, ast::BuiltInType type, ast::Node *decl, bool isParam) {
+        int slot = cfg->numLocals();
+        int offset = isParam ? nextParamOffset-- : nextOffset++;
+        cfg->locals.push_back(Local{name, type, decl, isParam, offset});
+        names.emplace_back(name, slot);
+        return slot;
+    }
+
+    int CFGBuilder::resolve(const std::string &name) const {
+        for (auto it = names.rbegin(); it != names.rend(); ++it) {
+            if (it->first == name) {
+                return it->second;
+            }
+        }
+        return -1;
+    }
+
+    void CFGBuilder::visitScoped(ast::Statement &statement) {
+        beginScope();
+        statement.accept(*this);
+        endScope();
+    }
+
+    void CFGBuilder::finish() {
+        int numBlocks = cfg->numBlocks();
+
+        // Sort instructions by block, keeping program order inside each block
+        std::vector<int> counts(numBlocks + 1, 0);
+        for (int block : pendingBlocks) {
+            counts[block + 1]++;
+        }
+        for (int b = 0; b < numBlocks; ++b) {
+            cfg->blocks[b].firstInstr = counts[b];
+            cfg->blocks[b].numInstrs = counts[b + 1];
+            counts[b + 1] += counts[b];
+        }
+        cfg->instrs.resize(pendingInstrs.size());
+        for (size_t i = 0; i < pendingInstrs.size(); ++i) {
+            cfg->instrs[counts[pendingBlocks[i]]++] = pendingInstrs[i];
+        }
+
+        // Successor and predecessor lists, in edge creation order
+        std::vector<int> succCounts(numBlocks + 1, 0);
+        std::vector<int> predCounts(numBlocks + 1, 0);
+        for (const auto &edge : edges) {
+            succCounts[edge.first + 1]++;
+            predCounts[edge.second + 1]++;
+        }
+        for (int b = 0; b < numBlocks; ++b) {
+            cfg->blocks[b].firstSucc = succCounts[b];
+            cfg->blocks[b].numSuccs = succCounts[b + 1];
+            succCounts[b + 1] += succCounts[b];
+            cfg->blocks[b].firstPred = predCounts[b];
+            cfg->blocks[b].numPreds = predCounts[b + 1];
+            predCounts[b + 1] += predCounts[b];
+        }
+        cfg->succs.resize(edges.size());
+        cfg->preds.resize(edges.size());
+        for (const auto &edge : edges) {
+            cfg->succs[succCounts[edge.first]++] = edge.second;
+            cfg->preds[predCounts[edge.second]++] = edge.first;
+        }
+
+        // Reachability and reverse post-order from the entry block
+        std::vector<std::pair<int, int>> stack;
+        std::vector<int> postOrder;
+        cfg->blocks[FunctionCFG::ENTRY].reachable = true;
+        stack.emplace_back(FunctionCFG::ENTRY, 0);
+        while (!stack.empty()) {
+            int block = stack.back().first;
+            int &next = stack.back().second;
+            if (next < cfg->blocks[block].numSuccs) {
+                int succ = cfg->succsBegin(block)[next++];
+                if (!cfg->blocks[succ].reachable) {
+                    cfg->blocks[succ].reachable = true;
+                    stack.emplace_back(succ, 0);
+                }
+            } else {
+                postOrder.push_back(block);
+                stack.pop_back();
+            }
+        }
+        cfg->rpo.assign(postOrder.rbegin(), postOrder.rend());
+    }
+
+    FunctionCFG CFGBuilder::build(ast::FuncDecl &func) {
+        FunctionCFG graph;
+        graph.name = func.id->value;
+        graph.func = &func;
+
+        cfg = &graph;
+        loops.clear();
+        edges.clear();
+        pendingInstrs.clear();
+        pendingBlocks.clear();
+        names.clear();
+        scopeMarks.clear();
+        currentUses.clear();
+        inExp = false;
+        nextOffset = 0;
+        nextParamOffset = -1;
+
+        newBlock(); // FunctionCFG::ENTRY
+        newBlock(); // FunctionCFG::EXIT
+        current = FunctionCFG::ENTRY;
+
+        beginScope();
+        func.formals->accept(*this);
+        func.body->accept(*this);
+        endScope();
+        addEdge(current, FunctionCFG::EXIT);
+
+        finish();
+        cfg = nullptr;
+        return graph;
+    }
+
+    void CFGBuilder::visit(ast::Num &) {}
+
+    void CFGBuilder::visit(ast::NumB &) {}
+
+    void CFGBuilder::visit(ast::String &) {}
+
+    void CFGBuilder::visit(ast::Bool &) {}
+
+    void CFGBuilder::visit(ast::ID &node) {
+        int slot = resolve(node.value);
+        if (slot < 0) {
+            return; // Undefined names are reported by the semantic analysis
+        }
+        cfg->slotOfId[&node] = slot;
+        for (int use : currentUses) {
+            if (use == slot) {
+                return;
+            }
+        }
+        currentUses.push_back(slot);
+    }
+
+    void CFGBuilder::visit(ast::BinOp &node) {
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void CFGBuilder::visit(ast::RelOp &node) {
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void CFGBuilder::visit(ast::Not &node) {
+        node.exp->accept(*this);
+    }
+
+    // Short-circuit operators stay inside a single instruction; only their reads are recorded
+    void CFGBuilder::visit(ast::And &node) {
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void CFGBuilder::visit(ast::Or &node) {
+        node.left->accept(*this);
+        node.right->accept(*this);
+    }
+
+    void CFGBuilder::visit(ast::Type &) {}
+
+    void CFGBuilder::visit(ast::Cast &node) {
+        node.exp->accept(*this);
+    }
+
+    void CFGBuilder::visit(ast::ExpList &node) {
+        for (const auto &exp : node.exps) {
+            exp->accept(*this);
+        }
+    }
+
+    void CFGBuilder::visit(ast::Call &node) {
+        // A call nested in an expression only contributes its reads to the enclosing instruction
+        bool statement = !inExp;
+        inExp = true;
+        node.args->accept(*this);
+        inExp = !statement;
+        if (statement) {
+            addInstr(&node, InstrKind::Call, -1);
+        }
+    }
+
+    void CFGBuilder::visit(ast::Statements &node) {
+        beginScope();
+        for (const auto &statement : node.statements) {
+            statement->accept(*this);
+        }
+        endScope();
+    }
+
+    void CFGBuilder::visit(ast::Break &) {
+        if (!loops.empty()) {
+            addEdge(current, loops.back().second);
+        }
+        current = newBlock();
+    }
+
+    void CFGBuilder::visit(ast::Continue &) {
+        if (!loops.empty()) {
+            addEdge(current, loops.back().first);
+        }
+        current = newBlock();
+    }
+
+    void CFGBuilder::visit(ast::Return &node) {
+        if (node.exp) {
+            inExp = true;
+            node.exp->accept(*this);
+            inExp = false;
+        }
+        addInstr(&node, InstrKind::Return, -1);
+        addEdge(current, FunctionCFG::EXIT);
+        current = newBlock();
+    }
+
+    void CFGBuilder::visit(ast::If &node) {
+        inExp = true;
+        node.condition->accept(*this);
+        inExp = false;
+        addInstr(node.condition.get(), InstrKind::Branch, -1);
+
+        int condBlock = current;
+        int thenBlock = newBlock();
+        int elseBlock = node.otherwise ? newBlock() : -1;
+        int joinBlock = newBlock();
+        addEdge(condBlock, thenBlock);
+        addEdge(condBlock, node.otherwise ? elseBlock : joinBlock);
+
+        current = thenBlock;
+        visitScoped(*node.then);
+        addEdge(current, joinBlock);
+
+        if (node.otherwise) {
+            current = elseBlock;
+            visitScoped(*node.otherwise);
+            addEdge(current, joinBlock);
+        }
+
+        current = joinBlock;
+    }
+
+    void CFGBuilder::visit(ast::While &node) {
+        int headerBlock = newBlock();
+        addEdge(current, headerBlock);
+        current = headerBlock;
+
+        inExp = true;
+        node.condition->accept(*this);
+        inExp = false;
+        addInstr(node.condition.get(), InstrKind::Branch, -1);
+
+        int bodyBlock = newBlock();
+        int exitBlock = newBlock();
+        addEdge(headerBlock, bodyBlock);
+        addEdge(headerBlock, exitBlock);
+
+        loops.emplace_back(headerBlock, exitBlock);
+        current = bodyBlock;
+        visitScoped(*node.body);
+        addEdge(current, headerBlock);
+        loops.pop_back();
+
+        current = exitBlock;
+    }
+
+    void CFGBuilder::visit(ast::VarDecl &node) {
+        // The initializer is resolved before the new name becomes visible
+        if (node.init_exp) {
+            inExp = true;
+            node.init_exp->accept(*this);
+            inExp = false;
+        }
+        int slot = declare(node.id->value, node.type->type, &node, false);
+        addInstr(&node, InstrKind::VarDecl, slot);
+    }
+
+    void CFGBuilder::visit(ast::Assign &node) {
+        inExp = true;
+        node.exp->accept(*this);
+        inExp = false;
+        addInstr(&node, InstrKind::Assign, resolve(node.id->value));
+    }
+
+    void CFGBuilder::visit(ast::Formal &node) {
+        declare(node.id->value, node.type->type, &node, true);
+    }
+
+    void CFGBuilder::visit(ast::Formals &node) {
+        for (const auto &formal : node.formals) {
+            formal->accept(*this);
+        }
+    }
+
+    void CFGBuilder::visit(ast::FuncDecl &) {}
+
+    void CFGBuilder::visit(ast::Funcs &) {}
+
+    std::vector<FunctionCFG> buildAll(ast::Funcs &funcs) {
+        CFGBuilder builder;
+        std::vector<FunctionCFG> graphs;
+        graphs.reserve(funcs.funcs.size());
+        for (const auto &func : funcs.funcs) {
+            graphs.push_back(builder.build(*func));
+        }
+        return graphs;
+    }
+}
@@ -0,0 +1,225 @@
+#ifndef CFG_HPP
+#define CFG_HPP
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "nodes.hpp"
+
+namespace cfg {
+
+    /* Kinds of instructions stored in a basic block */
+    enum class InstrKind {
+        VarDecl,  // Local declaration, with or without an initializer
+        Assign,   // Assignment to a local
+        Call,     // Call used as a statement
+        Return,   // Return, with or without a value
+        Branch    // Condition of an If/While, always the last instruction of its block
+    };
+
+    /* A single instruction. It points back into the AST, which must outlive the graph */
+    struct Instr {
+        // Statement or condition expression this instruction was built from
+        ast::Node *node;
+        // Kind of the instruction
+        InstrKind kind;
+        // Local slot written by this instruction, or -1
+        int def;
+        // Range of local slots read by this instruction in FunctionCFG::uses
+        int firstUse;
+        int numUses;
+    };
+
+    /* A basic block. All ranges index into the flat arrays of the owning FunctionCFG */
+    struct BasicBlock {
+        int firstInstr;
+        int numInstrs;
+        int firstSucc;
+        int numSuccs;
+        int firstPred;
+        int numPreds;
+        // False for blocks that cannot be reached from the entry, e.g. code after a return
+        bool reachable;
+    };
+
+    /* A local variable or parameter of the function, identified by its slot index */
+    struct Local {
+        // Name of the variable (shadowed names get distinct slots)
+        std::string name;
+        // Declared type
+        ast::BuiltInType type;
+        // VarDecl or Formal that introduced the variable
+        ast::Node *decl;
+        // True for formal parameters
+        bool isParam;
+        // Frame offset under the scope rules of the symbol table: parameters count down from -1,
+        // locals count up from 0 and a scope's offsets are reused once it ends
+        int offset;
+    };
+
+    /* Control-flow graph of one function body.
+     * Blocks, instructions and edges live in contiguous arrays; a block refers to its
+     * instructions and neighbours through [first, first + count) ranges.
+     * For a block ending with a Branch, the first successor is the true target and the
+     * second one is the false target.
+     */
+    class FunctionCFG {
+    public:
+        // Index of the entry block
+        static constexpr int ENTRY = 0;
+        // Index of the (empty) exit block every return and fall-through edge leads to
+        static constexpr int EXIT = 1;
+
+        // Name of the function
+        std::string name;
+        // Function the graph was built from
+        ast::FuncDecl *func = nullptr;
+
+        std::vector<BasicBlock> blocks;
+        std::vector<Instr> instrs;
+        std::vector<int> succs;
+        std::vector<int> preds;
+        std::vector<int> uses;
+        std::vector<Local> locals;
+        // Slot every resolved ID node refers to
+        std::unordered_map<const ast::Node *, int> slotOfId;
+
+        // Reachable blocks in reverse post-order, starting with the entry block
+        std::vector<int> rpo;
+
+        int numBlocks() const { return static_cast<int>(blocks.size()); }
+
+        int numLocals() const { return static_cast<int>(locals.size()); }
+
+        const Instr *instrsBegin(int block) const { return instrs.data() + blocks[block].firstInstr; }
+
+        const Instr *instrsEnd(int block) const { return instrsBegin(block) + blocks[block].numInstrs; }
+
+        const int *succsBegin(int block) const { return succs.data() + blocks[block].firstSucc; }
+
+        const int *succsEnd(int block) const { return succsBegin(block) + blocks[block].numSuccs; }
+
+        const int *predsBegin(int block) const { return preds.data() + blocks[block].firstPred; }
+
+        const int *predsEnd(int block) const { return predsBegin(block) + blocks[block].numPreds; }
+
+        const int *usesBegin(const Instr &instr) const { return uses.data() + instr.firstUse; }
+
+        const int *usesEnd(const Instr &instr) const { return usesBegin(instr) + instr.numUses; }
+
+        // Prints the graph in a human-readable format
+        void dumpText(std::ostream &os) const;
+
+        // Prints the graph in Graphviz dot format
+        void dumpDot(std::ostream &os) const;
+    };
+
+    /* Builds the control-flow graph of a function.
+     * The builder resolves every identifier to a local slot while walking the body, so later
+     * analyses can work on dense slot indices instead of names.
+     */
+    class CFGBuilder : public Visitor {
+    private:
+        FunctionCFG *cfg;
+        // Block currently being filled
+        int current;
+        // Per enclosing loop: (continue target, break target)
+        std::vector<std::pair<int, int>> loops;
+        // Edges and instructions in creation order, sorted into the flat arrays by finish()
+        std::vector<std::pair<int, int>> edges;
+        std::vector<Instr> pendingInstrs;
+        std::vector<int> pendingBlocks;
+        // Visible names and the slot each one is bound to, with a start marker per scope
+        std::vector<std::pair<std::string, int>> names;
+        std::vector<std::pair<size_t, int>> scopeMarks;
+        // Next scope-rule offsets for locals and parameters
+        int nextOffset;
+        int nextParamOffset;
+        // Slots read by the instruction currently being built
+        std::vector<int> currentUses;
+        // True while visiting an expression, so nested calls are not emitted as statements
+        bool inExp;
+
+        int newBlock();
+
+        void addEdge(int from, int to);
+
+        void addInstr(ast::Node *node, InstrKind kind, int def);
+
+        void beginScope();
+
+        void endScope();
+
+        int declare(const std::string &name, ast::BuiltInType type, ast::Node *decl, bool isParam);
+
+        int resolve(const std::string &name) const;
+
+        // Visits a statement in its own scope, as If and While bodies are scoped
+        void visitScoped(ast::Statement &statement);
+
+        void finish();
+
+    public:
+        // Builds the graph for the given function
+        FunctionCFG build(ast::FuncDecl &func);
+
+        void visit(ast::Num &node) override;
+
+        void visit(ast::NumB &node) override;
+
+        void visit(ast::String &node) override;
+
+        void visit(ast::Bool &node) override;
+
+        void visit(ast::ID &node) override;
+
+        void visit(ast::BinOp &node) override;
+
+        void visit(ast::RelOp &node) override;
+
+        void visit(ast::Not &node) override;
+
+        void visit(ast::And &node) override;
+
+        void visit(ast::Or &node) override;
+
+        void visit(ast::Type &node) override;
+
+        void visit(ast::Cast &node) override;
+
+        void visit(ast::ExpList &node) override;
+
+        void visit(ast::Call &node) override;
+
+        void visit(ast::Statements &node) override;
+
+        void visit(ast::Break &node) override;
+
+        void visit(ast::Continue &node) override;
+
+        void visit(ast::Return &node) override;
+
+        void visit(ast::If &node) override;
+
+        void visit(ast::While &node) override;
+
+        void visit(ast::VarDecl &node) override;
+
+        void visit(ast::Assign &node) override;
+
+        void visit(ast::Formal &node) override;
+
+        void visit(ast::Formals &node) override;
+
+        void visit(ast::FuncDecl &node) override;
+
+        void visit(ast::Funcs &node) override;
+    };
+
+    // Builds the graphs of all functions in the program, in declaration order
+    std::vector<FunctionCFG> buildAll(ast::Funcs &funcs);
+}
+
+#endif //CFG_HPP
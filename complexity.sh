@@ -0,0 +1,149 @@
+#!/bin/bash
+# Complexity stress test of ./hw3. Generates programs growing along one dimension, times every stage with
+# --time-passes, and fits the exponent k of time ~ size^k per stage by least squares over the log-log points.
+# Stages whose exponent exceeds the threshold are flagged, so superlinear regressions are caught early.
+# Dimensions: depth (nested blocks, ifs and loops), locals (variables in one scope), args (parameters and
+# arguments of one call), funcs (functions per file), expr (operands of one expression). Sizes double from
+# the base size of the dimension.
+# Usage: ./complexity.sh [dimension|all] [steps] [threshold]
+# Set FLAGS to change the options passed to ./hw3 (default -O2 -Wall), RUNS to change the number of runs of
+# which the fastest counts (default 3), and MIN_US to change the time below which a point is too noisy to fit
+# (default 50).
+
+gen_program() {
+    # Program of size $2 along dimension $1
+    awk -v dim="$1" -v n="$2" '
+    BEGIN {
+        if (dim == "depth") {
+            print "void main() {"
+            print "    int x = 0;"
+            for (i = 0; i < n; i++) {
+                if (i % 3 == 0) print "{"
+                else if (i % 3 == 1) print "if (x < " i ") {"
+                else print "while (x > " i ") {"
+            }
+            print "x = x + 1;"
+            for (i = 0; i < n; i++) print "}"
+            print "}"
+        } else if (dim == "locals") {
+            print "void main() {"
+            print "    int v0 = 0;"
+            for (i = 1; i < n; i++) print "    int v" i " = v" (i - 1) " + 1;"
+            print "    printi(v" (n - 1) ");"
+            print "}"
+        } else if (dim == "args") {
+            printf "int f(int a0"
+            for (i = 1; i < n; i++) printf ", int a%d", i
+            print ") { return a0 + a" (n - 1) "; }"
+            printf "void main() { printi(f(0"
+            for (i = 1; i < n; i++) printf ", %d", i
+            print ")); }"
+        } else if (dim == "funcs") {
+            print "int f0(int a) { return a; }"
+            for (i = 1; i < n; i++) print "int f" i "(int a) { return f" (i - 1) "(a) + 1; }"
+            print "void main() { printi(f" (n - 1) "(1)); }"
+        } else if (dim == "expr") {
+            print "void main() {"
+            print "    int x = 1;"
+            printf "    x = x"
+            for (i = 1; i < n; i++) {
+                format = i % 2 ? " + %d" : " * x"
+                printf format, i
+            }
+            print ";"
+            print "    printi(x);"
+            print "}"
+        }
+    }'
+}
+
+base_size() {
+    case "$1" in
+        depth) echo 64 ;;
+        args) echo 64 ;;
+        *) echo 256 ;;
+    esac
+}
+
+measure() {
+    # Prints "stage micros" for every stage of one run on the program in $1: lex, parse, each pass (repeated
+    # passes summed), the total of the passes, and the wall time of the whole run
+    local start end
+    start=$(date +%s%N)
+    ./hw3 $FLAGS --time-passes < "$1" 2> complexity.err > complexity.out
+    end=$(date +%s%N)
+    awk '
+        /^(lex|parse):/ {
+            for (i = 1; i <= NF; i++) if ($i == "us") { print substr($1, 1, length($1) - 1), $(i - 1); break }
+        }
+        /^ *[0-9]+ +[0-9]+ +[0-9]+  [a-z-]+$/ { times[$4] += $1 }
+        END { for (stage in times) print stage, times[stage] }' complexity.err
+    echo "wall $(((end - start) / 1000))"
+}
+
+fit() {
+    # Reads "size stage micros" points and prints the fitted exponent of every stage, flagging those above
+    # the threshold $1. Exits with status 1 if any stage was flagged
+    awk -v threshold="$1" -v minimum="$MIN_US" '
+        $3 >= minimum {
+            x = log($1); y = log($3)
+            n[$2]++; sx[$2] += x; sy[$2] += y; sxx[$2] += x * x; sxy[$2] += x * y
+        }
+        { seen[$2] = 1 }
+        END {
+            flagged = 0
+            for (stage in seen) {
+                if (n[stage] < 3) {
+                    printf "    %-12s too fast to fit\n", stage
+                    continue
+                }
+                k = (n[stage] * sxy[stage] - sx[stage] * sy[stage]) / (n[stage] * sxx[stage] - sx[stage] * sx[stage])
+                mark = k > threshold ? "  SUPERLINEAR" : ""
+                flagged = flagged || k > threshold
+                printf "    %-12s exponent %.2f%s\n", stage, k, mark
+            }
+            exit flagged
+        }'
+}
+
+dimension="${1:-all}"
+steps="${2:-6}"
+threshold="${3:-1.3}"
+FLAGS="${FLAGS:--O2 -Wall}"
+RUNS="${RUNS:-3}"
+MIN_US="${MIN_US:-50}"
+input="complexity.in"
+failed=0
+
+if [ "$dimension" = "all" ]; then
+    dimensions="depth locals args funcs expr"
+else
+    dimensions="$dimension"
+fi
+
+for dim in $dimensions; do
+    size=$(base_size "$dim")
+    points=""
+    echo "Dimension ${dim}, threshold ${threshold}"
+    for ((step = 0; step < steps; step++, size *= 2)); do
+        gen_program "$dim" "$size" > "$input"
+        # The fastest of the runs, per stage
+        best=$(for ((run = 0; run < RUNS; run++)); do measure "$input"; done |
+            awk '!($1 in t) || $2 < t[$1] { t[$1] = $2 } END { for (s in t) print s, t[s] }' | sort)
+        # A checked program prints its global scope; anything else is a diagnostic
+        if ! head -1 complexity.out | grep -q "^---begin global scope---"; then
+            echo "    size ${size}: $(head -1 complexity.out), input kept in complexity.fail.${dim}"
+            cp "$input" "complexity.fail.${dim}"
+            failed=1
+            break
+        fi
+        echo "    size ${size}: $(echo "$best" | awk '{ printf "%s %s us  ", $1, $2 }')"
+        points+=$(echo "$best" | awk -v size="$size" '{ print size, $1, $2 }')$'\n'
+    done
+    if ! printf "%s" "$points" | fit "$threshold"; then
+        failed=1
+    fi
+done
+
+rm -f "$input" complexity.out complexity.err
+exit "$failed"
@@ -0,0 +1,267 @@
+#include "dataflow.hpp"
+#include "output.hpp"
+#include <deque>
+
+namespace dataflow {
+
+    /* Helper functions */
+
+    // True if the instruction leaves its slot assigned; a VarDecl without an initializer does not
+    static bool assigns(const cfg::Instr &instr) {
+        return instr.kind != cfg::InstrKind::VarDecl || dynamic_cast<ast::VarDecl *>(instr.node)->init_exp != nullptr;
+    }
+
+    /* BitSet implementation */
+
+    BitSet::BitSet(int width, bool value) : words((width + 63) / 64, value ? ~uint64_t(0) : 0), width(width) {
+        if (value && width % 64 != 0) {
+            words.back() &= (uint64_t(1) << (width % 64)) - 1;
+        }
+    }
+
+    void BitSet::fill(bool value) {
+        *this = BitSet(width, value);
+    }
+
+    bool BitSet::unionWith(const BitSet &other) {
+        uint64_t changed = 0;
+        for (size_t i = 0; i < words.size(); ++i) {
+            uint64_t word = words[i] | other.words[i];
+            changed |= word ^ words[i];
+            words[i] = word;
+        }
+        return changed != 0;
+    }
+
+    bool BitSet::intersectWith(const BitSet &other) {
+        uint64_t changed = 0;
+        for (size_t i = 0; i < words.size(); ++i) {
+            uint64_t word = words[i] & other.words[i];
+            changed |= word ^ words[i];
+            words[i] = word;
+        }
+        return changed != 0;
+    }
+
+    void BitSet::subtract(const BitSet &other) {
+        for (size_t i = 0; i < words.size(); ++i) {
+            words[i] &= ~other.words[i];
+        }
+    }
+
+    int BitSet::count() const {
+        int result = 0;
+        for (uint64_t word : words) {
+            result += __builtin_popcountll(word);
+        }
+        return result;
+    }
+
+    /* Worklist solver */
+
+    Solution solve(const cfg::FunctionCFG &graph, const Problem &problem) {
+        bool forward = problem.direction == Direction::FORWARD;
+        bool top = problem.meet == Meet::INTERSECTION;
+        int numBlocks = graph.numBlocks();
+
+        Solution result;
+        result.in.assign(numBlocks, BitSet(problem.width, top));
+        result.out.assign(numBlocks, BitSet(problem.width, top));
+
+        // "Before" and "after" in the direction of the analysis
+        std::vector<BitSet> &before = forward ? result.in : result.out;
+        std::vector<BitSet> &after = forward ? result.out : result.in;
+        int boundaryBlock = forward ? cfg::FunctionCFG::ENTRY : cfg::FunctionCFG::EXIT;
+
+        std::deque<int> worklist;
+        std::vector<bool> queued(numBlocks, false);
+        if (forward) {
+            worklist.assign(graph.rpo.begin(), graph.rpo.end());
+        } else {
+            worklist.assign(graph.rpo.rbegin(), graph.rpo.rend());
+        }
+        for (int block : worklist) {
+            queued[block] = true;
+        }
+
+        BitSet value(problem.width);
+        while (!worklist.empty()) {
+            int block = worklist.front();
+            worklist.pop_front();
+            queued[block] = false;
+            result.visits++;
+
+            // Meet over the neighbours facts flow from
+            const int *first = forward ? graph.predsBegin(block) : graph.succsBegin(block);
+            const int *last = forward ? graph.predsEnd(block) : graph.succsEnd(block);
+            if (block == boundaryBlock) {
+                before[block] = problem.boundary;
+            } else {
+                value.fill(top);
+                for (const int *it = first; it != last; ++it) {
+                    if (!graph.blocks[*it].reachable) {
+                        continue;
+                    }
+                    if (top) {
+                        value.intersectWith(after[*it]);
+                    } else {
+                        value.unionWith(after[*it]);
+                    }
+                }
+                before[block] = value;
+            }
+
+            // Transfer
+            value = before[block];
+            value.subtract(problem.kill[block]);
+            value.unionWith(problem.gen[block]);
+            if (value == after[block]) {
+                continue;
+            }
+            after[block] = value;
+
+            // Re-queue the neighbours facts flow to
+            first = forward ? graph.succsBegin(block) : graph.predsBegin(block);
+            last = forward ? graph.succsEnd(block) : graph.predsEnd(block);
+            for (const int *it = first; it != last; ++it) {
+                if (graph.blocks[*it].reachable && !queued[*it]) {
+                    queued[*it] = true;
+                    worklist.push_back(*it);
+                }
+            }
+        }
+        return result;
+    }
+
+    /* Liveness implementation */
+
+    Liveness::Liveness(const cfg::FunctionCFG &graph) : graph(graph) {
+        int numBlocks = graph.numBlocks();
+        Problem problem{Direction::BACKWARD, Meet::UNION, graph.numLocals(), {}, {}, BitSet(graph.numLocals())};
+        problem.gen.assign(numBlocks, BitSet(graph.numLocals()));
+        problem.kill.assign(numBlocks, BitSet(graph.numLocals()));
+
+        for (int b = 0; b < numBlocks; ++b) {
+            // Upward-exposed reads, found by walking the block backwards
+            for (const cfg::Instr *instr = graph.instrsEnd(b); instr != graph.instrsBegin(b);) {
+                --instr;
+                if (instr->def >= 0) {
+                    problem.gen[b].reset(instr->def);
+                    problem.kill[b].set(instr->def);
+                }
+                for (const int *use = graph.usesBegin(*instr); use != graph.usesEnd(*instr); ++use) {
+                    problem.gen[b].set(*use);
+                }
+            }
+        }
+        solution = solve(graph, problem);
+    }
+
+    /* ReachingDefinitions implementation */
+
+    ReachingDefinitions::ReachingDefinitions(const cfg::FunctionCFG &graph)
+            : graph(graph), defOfInstr(graph.instrs.size(), -1) {
+        for (int slot = 0; slot < graph.numLocals(); ++slot) {
+            if (graph.locals[slot].isParam) {
+                defs.push_back(Definition{slot, -1});
+            }
+        }
+        for (size_t i = 0; i < graph.instrs.size(); ++i) {
+            if (graph.instrs[i].def >= 0) {
+                defOfInstr[i] = static_cast<int>(defs.size());
+                defs.push_back(Definition{graph.instrs[i].def, static_cast<int>(i)});
+            }
+        }
+
+        int numDefs = static_cast<int>(defs.size());
+        defsOfSlot.assign(graph.numLocals(), BitSet(numDefs));
+        for (int d = 0; d < numDefs; ++d) {
+            defsOfSlot[defs[d].slot].set(d);
+        }
+
+        int numBlocks = graph.numBlocks();
+        Problem problem{Direction::FORWARD, Meet::UNION, numDefs, {}, {}, BitSet(numDefs)};
+        problem.gen.assign(numBlocks, BitSet(numDefs));
+        problem.kill.assign(numBlocks, BitSet(numDefs));
+        for (int d = 0; d < numDefs && defs[d].instr < 0; ++d) {
+            problem.boundary.set(d);
+        }
+
+        for (int b = 0; b < numBlocks; ++b) {
+            int first = graph.blocks[b].firstInstr;
+            for (int i = first; i < first + graph.blocks[b].numInstrs; ++i) {
+                int d = defOfInstr[i];
+                if (d < 0) {
+                    continue;
+                }
+                const BitSet &others = defsOfSlot[defs[d].slot];
+                problem.gen[b].subtract(others);
+                problem.gen[b].set(d);
+                problem.kill[b].unionWith(others);
+            }
+        }
+        solution = solve(graph, problem);
+    }
+
+    /* DefiniteAssignment implementation */
+
+    DefiniteAssignment::DefiniteAssignment(const cfg::FunctionCFG &graph) : graph(graph) {
+        int numBlocks = graph.numBlocks();
+        int numLocals = graph.numLocals();
+        Problem problem{Direction::FORWARD, Meet::INTERSECTION, numLocals, {}, {}, BitSet(numLocals)};
+        problem.gen.assign(numBlocks, BitSet(numLocals));
+        problem.kill.assign(numBlocks, BitSet(numLocals));
+        for (int slot = 0; slot < numLocals; ++slot) {
+            if (graph.locals[slot].isParam) {
+                problem.boundary.set(slot);
+            }
+        }
+
+        for (int b = 0; b < numBlocks; ++b) {
+            for (const cfg::Instr *instr = graph.instrsBegin(b); instr != graph.instrsEnd(b); ++instr) {
+                if (instr->def < 0) {
+                    continue;
+                }
+                if (assigns(*instr)) {
+                    problem.gen[b].set(instr->def);
+                    problem.kill[b].reset(instr->def);
+                } else {
+                    problem.gen[b].reset(instr->def);
+                    problem.kill[b].set(instr->def);
+                }
+            }
+        }
+        solution = solve(graph, problem);
+    }
+
+    /* Warnings */
+
+    void reportWarnings(const cfg::FunctionCFG &graph, const DefiniteAssignment &assignment) {
+        std::vector<bool> read(graph.numLocals(), false);
+
+        for (int block : graph.rpo) {
+            BitSet assigned = assignment.solution.in[block];
+            for (const cfg::Instr *instr = graph.instrsBegin(block); instr != graph.instrsEnd(block); ++instr) {
+                for (const int *use = graph.usesBegin(*instr); use != graph.usesEnd(*instr); ++use) {
+                    read[*use] = true;
+                    if (!assigned.test(*use)) {
+                        output::warnUnassigned(instr->node->line(), graph.locals[*use].name);
+                    }
+                }
+                if (instr->def >= 0) {
+                    if (assigns(*instr)) {
+                        assigned.set(instr->def);
+                    } else {
+                        assigned.reset(instr->def);
+                    }
+                }
+            }
+        }
+
+        for (int slot = 0; slot < graph.numLocals(); ++slot) {
+            if (!read[slot] && !graph.locals[slot].isParam) {
+                output::warnUnused(graph.locals[slot].decl->line(), graph.locals[slot].name);
+            }
+        }
+    }
+}
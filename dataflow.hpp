@@ -0,0 +1,148 @@
+#ifndef DATAFLOW_HPP
+#define DATAFLOW_HPP
+
+#include <cstdint>
+#include <vector>
+#include "cfg.hpp"
+
+namespace dataflow {
+
+    /* Dense fixed-width bit set */
+    class BitSet {
+    private:
+        std::vector<uint64_t> words;
+        int width;
+
+    public:
+        // Constructor that receives the number of bits and their initial value
+        explicit BitSet(int width = 0, bool value = false);
+
+        int size() const { return width; }
+
+        bool test(int bit) const { return (words[bit >> 6] >> (bit & 63)) & 1; }
+
+        void set(int bit) { words[bit >> 6] |= uint64_t(1) << (bit & 63); }
+
+        void reset(int bit) { words[bit >> 6] &= ~(uint64_t(1) << (bit & 63)); }
+
+        // Sets every bit to the given value
+        void fill(bool value);
+
+        // this |= other, returns true if this changed
+        bool unionWith(const BitSet &other);
+
+        // this &= other, returns true if this changed
+        bool intersectWith(const BitSet &other);
+
+        // this &= ~other
+        void subtract(const BitSet &other);
+
+        // Number of set bits
+        int count() const;
+
+        bool operator==(const BitSet &other) const { return words == other.words; }
+
+        bool operator!=(const BitSet &other) const { return words != other.words; }
+    };
+
+    /* Direction in which facts flow along the graph */
+    enum class Direction {
+        FORWARD,
+        BACKWARD
+    };
+
+    /* Operator combining facts where paths join */
+    enum class Meet {
+        UNION,        // "may" problems
+        INTERSECTION  // "must" problems
+    };
+
+    /* A gen/kill problem over the blocks of one function.
+     * The transfer function of block b is out = gen[b] | (in & ~kill[b]) (with in/out swapped
+     * for backward problems).
+     */
+    struct Problem {
+        Direction direction;
+        Meet meet;
+        // Number of facts, i.e. the width of every set
+        int width;
+        std::vector<BitSet> gen;
+        std::vector<BitSet> kill;
+        // Facts holding on entry to the function (forward) or on exit from it (backward)
+        BitSet boundary;
+    };
+
+    /* Fixed point of a problem. in/out are relative to program order for both directions */
+    struct Solution {
+        std::vector<BitSet> in;
+        std::vector<BitSet> out;
+        // Number of block transfer evaluations the worklist needed
+        int visits = 0;
+    };
+
+    // Solves the problem with a worklist seeded in (reverse) post-order. Unreachable blocks are skipped
+    Solution solve(const cfg::FunctionCFG &graph, const Problem &problem);
+
+    /* Live variables: slot s is live at a point if some path from it reads s before writing it */
+    class Liveness {
+    public:
+        const cfg::FunctionCFG &graph;
+        Solution solution;
+
+        explicit Liveness(const cfg::FunctionCFG &graph);
+
+        // Walks the block backwards, calling visit(instr, liveAfter) for every instruction
+        template<typename Visit>
+        void forEachInstr(int block, Visit visit) const {
+            BitSet live = solution.out[block];
+            for (const cfg::Instr *instr = graph.instrsEnd(block); instr != graph.instrsBegin(block);) {
+                --instr;
+                visit(*instr, live);
+                if (instr->def >= 0) {
+                    live.reset(instr->def);
+                }
+                for (const int *use = graph.usesBegin(*instr); use != graph.usesEnd(*instr); ++use) {
+                    live.set(*use);
+                }
+            }
+        }
+    };
+
+    /* A definition of a local: an instruction writing it, or the incoming value of a parameter */
+    struct Definition {
+        // Slot that is written
+        int slot;
+        // Index into FunctionCFG::instrs, or -1 for a parameter
+        int instr;
+    };
+
+    /* Reaching definitions: definition d reaches a point if some path from d to it does not rewrite d's slot */
+    class ReachingDefinitions {
+    public:
+        const cfg::FunctionCFG &graph;
+        std::vector<Definition> defs;
+        // Definition index of every instruction, or -1 if it defines nothing
+        std::vector<int> defOfInstr;
+        // Per slot, the set of its definitions
+        std::vector<BitSet> defsOfSlot;
+        Solution solution;
+
+        explicit ReachingDefinitions(const cfg::FunctionCFG &graph);
+    };
+
+    /* Definite assignment: slot s is assigned at a point if every path to it writes s.
+     * A VarDecl without an initializer declares the slot unassigned.
+     */
+    class DefiniteAssignment {
+    public:
+        const cfg::FunctionCFG &graph;
+        Solution solution;
+
+        explicit DefiniteAssignment(const cfg::FunctionCFG &graph);
+    };
+
+    // Warns about reads of possibly unassigned locals and about locals that are never read
+    void reportWarnings(const cfg::FunctionCFG &graph, const DefiniteAssignment &assignment);
+}
+
+#endif //DATAFLOW_HPP
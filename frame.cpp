@@ -0,0 +1,75 @@
+#include "frame.hpp"
+
+namespace frame {
+
+    FrameLayout layoutFrame(const cfg::FunctionCFG &graph, const dataflow::Liveness &liveness) {
+        int numLocals = graph.numLocals();
+
+        FrameLayout layout;
+        layout.name = graph.name;
+        layout.offsets.assign(numLocals, 0);
+        for (int slot = 0; slot < numLocals; ++slot) {
+            const cfg::Local &local = graph.locals[slot];
+            if (local.isParam) {
+                layout.offsets[slot] = local.offset;
+            } else if (local.offset + 1 > layout.scopedSize) {
+                layout.scopedSize = local.offset + 1;
+            }
+        }
+
+        // Two locals interfere if one is written while the other is live
+        std::vector<dataflow::BitSet> interferes(numLocals, dataflow::BitSet(numLocals));
+        for (int block : graph.rpo) {
+            liveness.forEachInstr(block, [&](const cfg::Instr &instr, const dataflow::BitSet &liveAfter) {
+                if (instr.def < 0) {
+                    return;
+                }
+                for (int other = 0; other < numLocals; ++other) {
+                    if (other != instr.def && liveAfter.test(other)) {
+                        interferes[instr.def].set(other);
+                        interferes[other].set(instr.def);
+                    }
+                }
+            });
+        }
+
+        // Greedy assignment in declaration order: each local takes the lowest slot no interfering local holds
+        std::vector<std::vector<int>> holders;
+        for (int slot = 0; slot < numLocals; ++slot) {
+            if (graph.locals[slot].isParam) {
+                continue;
+            }
+            int offset = 0;
+            for (; offset < static_cast<int>(holders.size()); ++offset) {
+                bool free = true;
+                for (int holder : holders[offset]) {
+                    if (interferes[slot].test(holder)) {
+                        free = false;
+                        break;
+                    }
+                }
+                if (free) {
+                    break;
+                }
+            }
+            if (offset == static_cast<int>(holders.size())) {
+                holders.emplace_back();
+            }
+            holders[offset].push_back(slot);
+            layout.offsets[slot] = offset;
+        }
+        layout.packedSize = static_cast<int>(holders.size());
+        return layout;
+    }
+
+    void recordOffsets(const cfg::FunctionCFG &graph, const FrameLayout &layout, PackedOffsets &offsets) {
+        for (int slot = 0; slot < graph.numLocals(); ++slot) {
+            offsets[graph.locals[slot].decl] = layout.offsets[slot];
+        }
+    }
+
+    void report(std::ostream &os, const FrameLayout &layout) {
+        os << "function " << layout.name << ": frame size " << layout.scopedSize << " -> " << layout.packedSize
+           << std::endl;
+    }
+}
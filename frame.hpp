@@ -0,0 +1,38 @@
+#ifndef FRAME_HPP
+#define FRAME_HPP
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cfg.hpp"
+#include "dataflow.hpp"
+
+namespace frame {
+
+    /* Frame offsets of a function's locals after packing */
+    struct FrameLayout {
+        // Name of the function
+        std::string name;
+        // Offset of every local slot. Parameters keep their negative offsets
+        std::vector<int> offsets;
+        // Number of local frame slots under the scope rules of the symbol table
+        int scopedSize = 0;
+        // Number of local frame slots after packing
+        int packedSize = 0;
+    };
+
+    // Offset of every packed declaration (VarDecl or Formal), for printing and code generation
+    using PackedOffsets = std::unordered_map<const ast::Node *, int>;
+
+    // Packs locals whose live ranges do not overlap into shared frame slots
+    FrameLayout layoutFrame(const cfg::FunctionCFG &graph, const dataflow::Liveness &liveness);
+
+    // Adds the offsets of the layout's declarations to the map
+    void recordOffsets(const cfg::FunctionCFG &graph, const FrameLayout &layout, PackedOffsets &offsets);
+
+    // Prints the frame size before and after packing
+    void report(std::ostream &os, const FrameLayout &layout);
+}
+
+#endif //FRAME_HPP
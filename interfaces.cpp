@@ -0,0 +1,124 @@
+#include "interfaces.hpp"
+#include "output.hpp"
+#include "resultcache.hpp"
+#include "types.hpp"
+#include <cctype>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
+
+namespace interfaces {
+
+    namespace {
+        const char *const MAGIC = "fanc-interface";
+
+        // Parses a type name; only the types a signature can use are accepted (no string parameters)
+        bool parseType(const std::string &name, bool isReturn, ast::BuiltInType &type) {
+            for (int i = 0; i < types::NUM_TYPES; i++) {
+                if (name == types::NAMES[i]) {
+                    type = static_cast<ast::BuiltInType>(i);
+                    return type != ast::BuiltInType::STRING && (isReturn || type != ast::BuiltInType::VOID);
+                }
+            }
+            return false;
+        }
+
+        bool isIdentifier(const std::string &name) {
+            if (name.empty() || !std::isalpha(static_cast<unsigned char>(name[0]))) {
+                return false;
+            }
+            for (char c : name) {
+                if (!std::isalnum(static_cast<unsigned char>(c))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::string format(const std::vector<Function> &functions) {
+            std::ostringstream os;
+            os << MAGIC << " " << FORMAT_VERSION << "\n";
+            for (const Function &function : functions) {
+                os << function.name << " " << types::name(function.returnType);
+                for (ast::BuiltInType type : function.params) {
+                    os << " " << types::name(type);
+                }
+                os << "\n";
+            }
+            return os.str();
+        }
+    }
+
+    bool Function::operator==(const Function &other) const {
+        return name == other.name && returnType == other.returnType && params == other.params;
+    }
+
+    std::vector<Function> exports(const ast::Funcs &program) {
+        std::vector<Function> functions;
+        functions.reserve(program.funcs.size());
+        for (const auto &func : program.funcs) {
+            Function function{func->id->value, func->return_type->type, {}};
+            for (const auto &formal : func->formals->formals) {
+                function.params.push_back(formal->type->type);
+            }
+            functions.push_back(std::move(function));
+        }
+        return functions;
+    }
+
+    bool write(const std::string &path, const std::vector<Function> &functions) {
+        std::string content = format(functions);
+        std::ifstream in(path, std::ios::binary);
+        if (in && std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()) == content) {
+            return true;
+        }
+        return resultcache::writeAtomically(path, content);
+    }
+
+    void import(const std::string &path, std::vector<Function> &imports) {
+        std::ifstream in(path);
+        std::string line;
+        std::string magic;
+        int version = 0;
+        if (!std::getline(in, line) || !(std::istringstream(line) >> magic >> version) || magic != MAGIC ||
+            version != FORMAT_VERSION) {
+            output::errorInterface(path);
+        }
+
+        std::unordered_map<std::string, size_t> imported;
+        for (size_t i = 0; i < imports.size(); i++) {
+            imported.emplace(imports[i].name, i);
+        }
+        while (std::getline(in, line)) {
+            std::istringstream words(line);
+            std::string name;
+            std::string type;
+            if (!(words >> name >> type)) {
+                output::errorInterface(path);
+            }
+            Function function{name, ast::BuiltInType::VOID, {}};
+            if (!isIdentifier(name) || !parseType(type, true, function.returnType)) {
+                output::errorInterface(path);
+            }
+            while (words >> type) {
+                function.params.emplace_back();
+                if (!parseType(type, false, function.params.back())) {
+                    output::errorInterface(path);
+                }
+            }
+
+            auto it = imported.find(name);
+            if (it == imported.end()) {
+                imported.emplace(name, imports.size());
+                imports.push_back(std::move(function));
+            } else if (!(imports[it->second] == function)) {
+                output::errorImportConflict(name);
+            }
+            // The same function imported again, through another interface, is simply skipped
+        }
+        if (in.bad()) {
+            output::errorInterface(path);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef INTERFACES_HPP
+#define INTERFACES_HPP
+
+#include <string>
+#include <vector>
+#include "nodes.hpp"
+
+/* Interface files for separate compilation. The interface of a unit lists the signatures of its functions,
+ * so other units can import them and be checked without its source. The format is text: a version line,
+ * then one function per line as its name, return type and parameter types, separated by spaces */
+namespace interfaces {
+
+    // Changed whenever the format changes; interfaces of other versions are rejected
+    constexpr int FORMAT_VERSION = 1;
+
+    /* The signature of an exported function */
+    struct Function {
+        std::string name;
+        ast::BuiltInType returnType;
+        std::vector<ast::BuiltInType> params;
+
+        bool operator==(const Function &other) const;
+    };
+
+    // Signatures of the functions of the program, in declaration order. Only the headers are needed, so the
+    // bodies may be left unparsed
+    std::vector<Function> exports(const ast::Funcs &program);
+
+    // Writes the interface to `path`. An interface whose content would not change is left untouched, so its
+    // modification time tells build tools whether units importing it need re-checking
+    bool write(const std::string &path, const std::vector<Function> &functions);
+
+    // Adds the functions of the interface at `path` to `imports`. Reports an error if the file is missing or
+    // malformed, or if it declares an already imported function with another signature
+    void import(const std::string &path, std::vector<Function> &imports);
+}
+
+#endif //INTERFACES_HPP
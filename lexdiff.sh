@@ -0,0 +1,82 @@
+#!/bin/bash
+# Differential tests of the scanning stage on generated inputs full of tokens, comments, strings and
+# lexical errors, comparing the output of ./hw3 --dump-tokens:
+#   threads: serial scanning against scanning on N threads
+#   simd:    the flex scanner against --lexer=simd, with random bytes appended to every input
+# Usage: ./lexdiff.sh {threads|simd} [rounds] [lines] [threads]
+
+gen_soup() {
+    # $2 lines of random lexical material, seeded with $1
+    awk -v seed="$1" -v lines="$2" 'BEGIN {
+        srand(seed)
+        n = split("void int byte bool and or not true false return if else while break continue x y1 abc Z9 main", words, " ")
+        m = split("; , ( ) { } = < <= > >= == != + - * /", ops, " ")
+        for (i = 0; i < lines; i++) {
+            line = ""
+            k = int(rand() * 12)
+            for (j = 0; j < k; j++) {
+                r = rand()
+                if (r < 0.35) line = line words[int(rand() * n) + 1]
+                else if (r < 0.55) line = line ops[int(rand() * m) + 1]
+                else if (r < 0.65) line = line int(rand() * 100000)
+                else if (r < 0.70) line = line int(rand() * 300) "b"
+                else if (r < 0.75) line = line "99999999999"
+                else if (r < 0.83) line = line "\"str // not a comment \\\" \\n \\\\ end\""
+                else if (r < 0.86) line = line "\"unterminated"
+                else if (r < 0.89) line = line "@#$"
+                else if (r < 0.92) line = line "\t"
+                else if (r < 0.94) line = line "0b0"
+                else line = line " "
+                line = line (rand() < 0.7 ? " " : "")
+            }
+            r = rand()
+            if (r < 0.1) line = line "// comment with \"quote and code int x = 1;"
+            else if (r < 0.15) line = line "//"
+            ending = rand() < 0.1 ? "\r\n" : "\n"
+            printf "%s%s", line, ending
+        }
+    }'
+}
+
+mode="$1"
+rounds="${2:-20}"
+lines="${3:-50000}"
+threads="${4:-8}"
+input="lexdiff.in"
+failed=0
+
+case "$mode" in
+    threads)
+        first="--dump-tokens"
+        second="--dump-tokens --lex-threads=${threads}"
+        ;;
+    simd)
+        first="--dump-tokens --lexer=flex"
+        second="--dump-tokens --lexer=simd"
+        ;;
+    *)
+        echo "Usage: $0 {threads|simd} [rounds] [lines] [threads]"
+        exit 1
+        ;;
+esac
+
+for ((round = 1; round <= rounds; round++)); do
+    gen_soup "$round" "$lines" > "$input"
+    if [ "$mode" = simd ]; then
+        head -c 4096 /dev/urandom >> "$input"
+    fi
+    ./hw3 $first < "$input" > lexdiff.first
+    ./hw3 $second < "$input" > lexdiff.second
+    if ! cmp -s lexdiff.first lexdiff.second; then
+        echo "Round ${round}: token streams differ, input kept in lexdiff.fail.${round}"
+        diff -a lexdiff.first lexdiff.second | head -5
+        cp "$input" "lexdiff.fail.${round}"
+        failed=1
+    fi
+done
+
+rm -f "$input" lexdiff.first lexdiff.second
+if [ "$failed" -eq 0 ]; then
+    echo "All ${rounds} rounds identical"
+fi
+exit "$failed"
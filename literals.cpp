@@ -0,0 +1,63 @@
+#include "literals.hpp"
+#include "memstats.hpp"
+
+namespace literals {
+
+    int StringPool::intern(const char *quoted, size_t length) {
+        memstats::TagScope tag(memstats::AST);
+        std::string_view body(quoted + 1, length - 2);
+
+        // Most literals have no escapes and are looked up without copying
+        if (body.find('\\') != std::string_view::npos) {
+            scratch.clear();
+            for (size_t i = 0; i < body.size(); i++) {
+                char c = body[i];
+                if (c == '\\') {
+                    // The scanner only accepts \n, \r, \t, \" and \\, so an escape is never the last character
+                    switch (body[++i]) {
+                        case 'n':
+                            c = '\n';
+                            break;
+                        case 'r':
+                            c = '\r';
+                            break;
+                        case 't':
+                            c = '\t';
+                            break;
+                        default:
+                            c = body[i];
+                            break;
+                    }
+                }
+                scratch.push_back(c);
+            }
+            body = scratch;
+        }
+        return add(body);
+    }
+
+    int StringPool::add(std::string_view value) {
+        memstats::TagScope tag(memstats::AST);
+        auto it = indices.find(value);
+        if (it != indices.end()) {
+            return it->second;
+        }
+        int index = static_cast<int>(strings.size());
+        strings.emplace_back(value);
+        indices.emplace(strings.back(), index);
+        return index;
+    }
+
+    const std::string &StringPool::get(int index) const {
+        return strings[index];
+    }
+
+    int StringPool::size() const {
+        return static_cast<int>(strings.size());
+    }
+
+    StringPool &pool() {
+        static StringPool instance;
+        return instance;
+    }
+}
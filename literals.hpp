@@ -0,0 +1,39 @@
+#ifndef LITERALS_HPP
+#define LITERALS_HPP
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace literals {
+
+    /* String literals of the program, with escapes decoded and each distinct value stored once */
+    class StringPool {
+    private:
+        // A deque, so the views used as keys of `indices` stay valid as the pool grows
+        std::deque<std::string> strings;
+        std::unordered_map<std::string_view, int> indices;
+        // Decoding buffer, reused across literals
+        std::string scratch;
+
+    public:
+        // Decodes a literal given with its quotes and returns the index of its value
+        int intern(const char *quoted, size_t length);
+
+        // Returns the index of an already decoded value, adding it if new
+        int add(std::string_view value);
+
+        // Decoded value of the literal with the given index
+        const std::string &get(int index) const;
+
+        // Number of distinct literals
+        int size() const;
+    };
+
+    // Pool of the program being compiled
+    StringPool &pool();
+}
+
+#endif //LITERALS_HPP
@@ -0,0 +1,98 @@
+#include "locations.hpp"
+
+namespace locations {
+
+    Span current = {1, 1, 1, 1};
+
+    /* Helper functions */
+
+    // Maps small negative and positive deltas to small unsigned values
+    static uint32_t zigzag(int value) {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    static int unzigzag(uint32_t value) {
+        return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+    }
+
+    // Reads a base-128 varint, advancing the offset
+    static uint32_t take(const std::vector<uint8_t> &bytes, size_t &offset) {
+        uint32_t value = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t byte = bytes[offset++];
+            value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return value;
+            }
+        }
+    }
+
+    // Decodes the entry at the offset, whose first line is relative to `line`, advancing both
+    static Span decode(const std::vector<uint8_t> &bytes, size_t &offset, int &line) {
+        Span span = {};
+        line += unzigzag(take(bytes, offset));
+        span.firstLine = line;
+        span.firstColumn = static_cast<int>(take(bytes, offset));
+        span.lastLine = line + static_cast<int>(take(bytes, offset));
+        span.lastColumn = static_cast<int>(take(bytes, offset));
+        return span;
+    }
+
+    /* Table class */
+
+    void Table::put(uint32_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    int Table::add(const Span &span) {
+        if (count % CHECKPOINT_INTERVAL == 0) {
+            checkpoints.push_back({static_cast<uint32_t>(bytes.size()), previousLine});
+        }
+        // Most nodes start on or near the line of the previous one, so each field usually takes one byte
+        put(zigzag(span.firstLine - previousLine));
+        put(static_cast<uint32_t>(span.firstColumn));
+        put(static_cast<uint32_t>(span.lastLine - span.firstLine));
+        put(static_cast<uint32_t>(span.lastColumn));
+        previousLine = span.firstLine;
+        return count++;
+    }
+
+    Span Table::get(int index) const {
+        const Checkpoint &checkpoint = checkpoints[index / CHECKPOINT_INTERVAL];
+        size_t offset = checkpoint.offset;
+        int line = checkpoint.previousLine;
+        Span span = {};
+        for (int i = index / CHECKPOINT_INTERVAL * CHECKPOINT_INTERVAL; i <= index; i++) {
+            span = decode(bytes, offset, line);
+        }
+        return span;
+    }
+
+    std::vector<Span> Table::decodeAll() const {
+        std::vector<Span> spans;
+        spans.reserve(count);
+        size_t offset = 0;
+        int line = 0;
+        for (int i = 0; i < count; i++) {
+            spans.push_back(decode(bytes, offset, line));
+        }
+        return spans;
+    }
+
+    int Table::size() const {
+        return count;
+    }
+
+    size_t Table::byteSize() const {
+        return bytes.size() + checkpoints.size() * sizeof(Checkpoint);
+    }
+
+    Table &table() {
+        static Table instance;
+        return instance;
+    }
+}
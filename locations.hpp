@@ -0,0 +1,62 @@
+#ifndef LOCATIONS_HPP
+#define LOCATIONS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace locations {
+
+    /* Source range of a token or a node, lines and columns starting at 1 */
+    struct Span {
+        int firstLine;
+        int firstColumn;
+        int lastLine;
+        int lastColumn;
+    };
+
+    /* Spans of all nodes in creation order, delta-encoded in a byte stream. Nodes keep only an
+     * index; spans are decoded when a diagnostic needs one */
+    class Table {
+    private:
+        // Entries between two points where decoding can start
+        static constexpr int CHECKPOINT_INTERVAL = 64;
+
+        /* Where decoding of an entry whose index is a multiple of CHECKPOINT_INTERVAL starts */
+        struct Checkpoint {
+            uint32_t offset;
+            // First line of the entry before it, the base of its delta
+            int previousLine;
+        };
+
+        std::vector<uint8_t> bytes;
+        std::vector<Checkpoint> checkpoints;
+        int count = 0;
+        int previousLine = 0;
+
+        void put(uint32_t value);
+
+    public:
+        // Appends a span and returns its index
+        int add(const Span &span);
+
+        Span get(int index) const;
+
+        // Decodes every span in index order, for walks that need the spans of all nodes
+        std::vector<Span> decodeAll() const;
+
+        // Number of spans
+        int size() const;
+
+        // Memory used by the encoded spans
+        size_t byteSize() const;
+    };
+
+    // Table of the program being compiled
+    Table &table();
+
+    // Span of the token or rule being processed, recorded by the Node constructor
+    extern Span current;
+}
+
+#endif //LOCATIONS_HPP
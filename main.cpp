@@ -1,19 +1,326 @@
 #include <iostream>
+#include <chrono>
+#include <cstring>
 #include "output.hpp"
 #include "nodes.hpp"
+#include "passes.hpp"
+#include "trace.hpp"
+#include "perfcounters.hpp"
+#include "memstats.hpp"
+#include "tokens.hpp"
+#include "rdparser.hpp"
+#include "astdump.hpp"
+#include "astcache.hpp"
+#include "resultcache.hpp"
+#include "interfaces.hpp"
+#include "posindex.hpp"
+#include <cstdlib>
+#include <charconv>
 
 // Extern from the bison-generated parser
 extern int yyparse();
 
 extern std::shared_ptr<ast::Node> program;
 
-int main() {
-    // Parse the input. The result is stored in the global variable `program`
-    yyparse();
+// Parses a byte count with an optional K, M or G suffix
+static long long parseSize(const char *text) {
+    char *suffix;
+    long long bytes = std::strtoll(text, &suffix, 10);
+    switch (*suffix) {
+        case 'G':
+            bytes <<= 10;
+            // fall through
+        case 'M':
+            bytes <<= 10;
+            // fall through
+        case 'K':
+            bytes <<= 10;
+            break;
+        default:
+            break;
+    }
+    return bytes;
+}
+
+int main(int argc, char *argv[]) {
+    // -O0/-O1/-O2 select the optimization pipeline (default -O0, semantic analysis only)
+    // --time-passes and --stats print per-pass timings and statistics counters on stderr
+    // --dump-cfg prints the control-flow graph of every function, --dump-cfg=dot prints it in dot format
+    // --dump-ssa prints the SSA form after the pipeline ran
+    // -Wall runs the dataflow analyses and reports unassigned and unused locals on stderr
+    // --pack-frames shares frame slots between locals with disjoint live ranges and reports the frame sizes
+    // --perf-counters prints cycles, instructions, cache and branch misses per phase (lex, parse, semantic, print)
+    // --mem-stats prints live and peak memory per subsystem at exit
+    // --mem-budget=<bytes>[K|M|G] aborts the compilation once live memory exceeds the budget
+    // --lex-threads=<n> scans large inputs on up to n threads
+    // --lexer=simd selects the hand-written SIMD scanner instead of the flex one (--lexer=flex)
+    // --dump-tokens prints the scanned tokens and stops
+    // --parser=pratt selects the hand-written recursive-descent parser instead of the bison one (--parser=bison)
+    // --dump-ast prints the syntax tree with node spans and stops
+    // --lazy-bodies parses only function headers with the hand-written parser; bodies are parsed when a pass needs them
+    // --signatures checks and prints the global scope (the function signatures) only, without parsing any body
+    // --ast-cache=<dir> loads the syntax tree of an unchanged input from <dir> instead of scanning and parsing it,
+    // and stores the tree of every input that compiles
+    // --emit-interface=<file> writes the function signatures of the input to <file> and stops, parsing no body
+    // --import=<file> makes the functions declared by the interface <file> of another unit callable (repeatable)
+    // --query=<type|definition|references>:<line>:<column> answers an editor query on the checked input (repeatable)
+    // --result-cache=<dir> replays the output of a compilation already done with the same compiler, options and input
+    // from <dir> without scanning it, and stores the output of every other one. Runs writing to stderr or to other
+    // files bypass it
+    // --result-cache-size=<bytes>[K|M|G] bounds the result cache, evicting least recently used entries (default 64M)
+    // --trace <file> writes phase timings and front-end counters to <file> in Chrome trace-event format
+    int level = 0;
+    bool timePasses = false;
+    bool stats = false;
+    const char *dumpCfg = nullptr;
+    bool dumpSsa = false;
+    bool warnings = false;
+    bool packFrames = false;
+    int lexThreads = 1;
+    tokens::Lexer lexer = tokens::Lexer::FLEX;
+    bool dumpTokens = false;
+    bool prattParser = false;
+    bool dumpAst = false;
+    bool lazyBodies = false;
+    bool signatures = false;
+    const char *astCache = nullptr;
+    const char *emitInterface = nullptr;
+    std::vector<const char *> imports;
+    std::vector<std::string> queries;
+    const char *resultCache = nullptr;
+    long long resultCacheSize = 64LL << 20;
+    bool perfCounters = false;
+    bool memStats = false;
+    bool tracing = false;
+    // The command line without the result cache options, part of the result cache key
+    std::string options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--result-cache", 14) != 0) {
+            options.append(argv[i]).push_back('\0');
+        }
+        if (std::strncmp(argv[i], "-O", 2) == 0 && argv[i][2] >= '0' && argv[i][2] <= '2' && !argv[i][3]) {
+            level = argv[i][2] - '0';
+        } else if (std::strcmp(argv[i], "--time-passes") == 0) {
+            timePasses = true;
+        } else if (std::strcmp(argv[i], "--stats") == 0) {
+            stats = true;
+        } else if (std::strcmp(argv[i], "--dump-cfg") == 0 || std::strcmp(argv[i], "--dump-cfg=dot") == 0) {
+            dumpCfg = argv[i] + 10;
+        } else if (std::strcmp(argv[i], "--dump-ssa") == 0) {
+            dumpSsa = true;
+        } else if (std::strcmp(argv[i], "-Wall") == 0) {
+            warnings = true;
+        } else if (std::strcmp(argv[i], "--pack-frames") == 0) {
+            packFrames = true;
+        } else if (std::strncmp(argv[i], "--lex-threads=", 14) == 0) {
+            const char *value = argv[i] + 14;
+            const char *end = value + std::strlen(value);
+            auto [last, error] = std::from_chars(value, end, lexThreads);
+            if (error != std::errc() || last != end || lexThreads < 1) {
+                std::cerr << "error: --lex-threads expects a positive number, got " << value << std::endl;
+                return 1;
+            }
+        } else if (std::strcmp(argv[i], "--lexer=simd") == 0) {
+            lexer = tokens::Lexer::SIMD;
+        } else if (std::strcmp(argv[i], "--lexer=flex") == 0) {
+            lexer = tokens::Lexer::FLEX;
+        } else if (std::strcmp(argv[i], "--dump-tokens") == 0) {
+            dumpTokens = true;
+        } else if (std::strcmp(argv[i], "--parser=pratt") == 0) {
+            prattParser = true;
+        } else if (std::strcmp(argv[i], "--parser=bison") == 0) {
+            prattParser = false;
+        } else if (std::strcmp(argv[i], "--dump-ast") == 0) {
+            dumpAst = true;
+        } else if (std::strcmp(argv[i], "--lazy-bodies") == 0) {
+            lazyBodies = true;
+        } else if (std::strcmp(argv[i], "--signatures") == 0) {
+            lazyBodies = true;
+            signatures = true;
+        } else if (std::strncmp(argv[i], "--ast-cache=", 12) == 0) {
+            astCache = argv[i] + 12;
+        } else if (std::strncmp(argv[i], "--emit-interface=", 17) == 0) {
+            emitInterface = argv[i] + 17;
+            lazyBodies = true;
+        } else if (std::strncmp(argv[i], "--import=", 9) == 0) {
+            imports.push_back(argv[i] + 9);
+        } else if (std::strncmp(argv[i], "--query=", 8) == 0) {
+            queries.emplace_back(argv[i] + 8);
+        } else if (std::strncmp(argv[i], "--result-cache=", 15) == 0) {
+            resultCache = argv[i] + 15;
+        } else if (std::strncmp(argv[i], "--result-cache-size=", 20) == 0) {
+            resultCacheSize = parseSize(argv[i] + 20);
+        } else if (std::strcmp(argv[i], "--perf-counters") == 0) {
+            perfCounters = true;
+            perf::start();
+            if (perf::enabled) {
+                // At exit, so runs stopped by a compile error are measured too
+                std::atexit([] { perf::report(std::cerr); });
+            }
+        } else if (std::strcmp(argv[i], "--mem-stats") == 0) {
+            memStats = true;
+            std::atexit([] { memstats::report(std::cerr); });
+        } else if (std::strncmp(argv[i], "--mem-budget=", 13) == 0) {
+            memstats::setBudget(parseSize(argv[i] + 13));
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            tracing = true;
+#ifndef FANC_NO_TRACE
+            trace::start(argv[++i]);
+#else
+            std::cerr << "warning: tracing was compiled out, ignoring --trace" << std::endl;
+            ++i;
+#endif
+        }
+    }
+
+    tokens::buffer().read(std::cin);
+    std::string_view source(tokens::buffer().source.data(), tokens::buffer().length());
+    // Only std::cout is replayed. Runs that also write to stderr (warnings, frame reports, timings, statistics,
+    // counters, query warnings) or to other files (traces, the AST cache, interfaces) always compile, so none of
+    // it is lost. Imported interfaces are inputs the key does not cover, so runs importing any also compile
+    bool sideOutputs = warnings || packFrames || timePasses || stats || perfCounters || memStats || tracing ||
+                       !queries.empty() || astCache || emitInterface || !imports.empty();
+    if (resultCache && !sideOutputs) {
+        std::string key = resultcache::key(source, options);
+        std::string output;
+        if (resultcache::lookup(resultCache, key, output)) {
+            std::cout << output;
+            return 0;
+        }
+        resultcache::capture(resultCache, key, resultCacheSize);
+    }
+    bool cached = false;
+    if (astCache && !dumpTokens) {
+        TRACE_SCOPE("ast-cache");
+        auto start = std::chrono::steady_clock::now();
+        program = astcache::load(astCache, source, signatures || emitInterface);
+        cached = program != nullptr;
+        if (timePasses) {
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            std::cerr << "ast-cache: " << (cached ? "hit" : "miss") << " in " << micros << " us" << std::endl;
+        }
+    }
+
+    // Scan the whole input into the token buffer, then parse it. The result is stored in the global variable `program`
+    if (!cached) {
+        TRACE_SCOPE("lex");
+        perf::Phase phase(perf::LEX);
+        auto start = std::chrono::steady_clock::now();
+        tokens::scan(tokens::buffer(), lexThreads, lexer);
+        // The lexer threads have joined, so an exceeded budget can be reported here
+        memstats::checkBudget();
+        if (timePasses) {
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            size_t bytes = tokens::buffer().length();
+            std::cerr << "lex: " << bytes << " bytes in " << micros << " us ("
+                      << (micros ? static_cast<double>(bytes) / micros : 0.0) << " MB/s)" << std::endl;
+        }
+    }
+    if (dumpTokens) {
+        tokens::dump(tokens::buffer(), std::cout);
+        return 0;
+    }
+    if (!cached) {
+        TRACE_SCOPE("parse");
+        perf::Phase phase(perf::PARSE);
+        memstats::TagScope tag(memstats::AST);
+        auto start = std::chrono::steady_clock::now();
+        if (prattParser || lazyBodies) {
+            program = rdparser::parse(lazyBodies);
+        } else {
+            yyparse();
+        }
+        memstats::checkBudget();
+        if (timePasses) {
+            auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            std::cerr << "parse: " << tokens::buffer().tokens.size() << " tokens in " << micros << " us" << std::endl;
+        }
+    }
+    if (dumpAst) {
+        astdump::dump(*program, std::cout);
+        return 0;
+    }
+    if (emitInterface) {
+        if (!interfaces::write(emitInterface, interfaces::exports(*std::dynamic_pointer_cast<ast::Funcs>(program)))) {
+            std::cerr << "error: cannot write interface file " << emitInterface << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    passes::PassManager manager;
+    passes::registerStandardPasses(manager);
+    passes::Context context;
+    context.program = std::dynamic_pointer_cast<ast::Funcs>(program);
+    for (const char *path : imports) {
+        interfaces::import(path, context.imports);
+    }
+    context.indexPositions = !queries.empty();
+
+    std::vector<std::string> pipeline;
+    if (signatures) {
+        // Only the function headers were parsed, so nothing needing a body may run
+        pipeline = {"signatures"};
+        dumpCfg = nullptr;
+        dumpSsa = false;
+    } else {
+        pipeline = passes::pipeline(level);
+        if (packFrames) {
+            // After the semantic pass, so only programs that check are laid out
+            pipeline.emplace_back("pack-frames");
+        }
+        if (warnings) {
+            pipeline.emplace_back("warnings");
+        }
+    }
+    // The first error is reported and ends the compilation, so the scopes are only printed once the program checked
+    manager.runPipeline(pipeline, context);
+    {
+        TRACE_SCOPE("print");
+        std::cout << context.scopes;
+    }
+    // The pipeline stops at the first error, so only checked trees reach the cache
+    if (astCache && !cached && !signatures) {
+        astcache::store(astCache, source, *context.program);
+    }
 
-    // TODO: shira - needs to use the class the we defined. we need to create an object from the type that we defined
+    if (dumpCfg) {
+        manager.require("cfg", context);
+        for (const auto &graph : context.graphs) {
+            if (std::strcmp(dumpCfg, "=dot") == 0) {
+                graph.dumpDot(std::cout);
+            } else {
+                graph.dumpText(std::cout);
+            }
+        }
+    }
+    if (dumpSsa) {
+        manager.require("ssa", context);
+        for (const auto &func : context.functions) {
+            func.dump(std::cout);
+        }
+    }
+    if (!queries.empty()) {
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string &query : queries) {
+            if (!posindex::query(context.positions, query, std::cout)) {
+                std::cerr << "warning: ignoring malformed query " << query << std::endl;
+            }
+        }
+        if (timePasses) {
+            auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - start).count();
+            std::cerr << "query: " << queries.size() << " in " << nanos << " ns" << std::endl;
+        }
+    }
 
-    // Print the AST using the SemanticVisitor
-    SemanticVisitor visitor;
-    program->accept(visitor);
+    if (timePasses) {
+        manager.printTimings(std::cerr);
+    }
+    if (stats) {
+        passes::printStats(std::cerr, context);
+    }
 }
@@ -0,0 +1,162 @@
+#include "memstats.hpp"
+#include "output.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+namespace memstats {
+
+    /* Accounting state */
+
+    static std::atomic<long long> allocationCount(0);
+    static std::atomic<long long> byteCount(0);
+    static std::atomic<long long> liveBytes[NUM_TAGS];
+    static std::atomic<long long> peakBytes[NUM_TAGS];
+    static std::atomic<long long> tagAllocations[NUM_TAGS];
+    static std::atomic<long long> totalLive(0);
+    static std::atomic<long long> budget(0);
+    static std::atomic<bool> budgetExceeded(false);
+    static thread_local Tag currentTag = OTHER;
+
+    static const char *tagNames[NUM_TAGS] = {"other", "lexer", "ast", "symbols", "printer", "ir"};
+
+    /* Every block starts with a header recording its size and tag, so frees are attributed correctly.
+     * The header keeps the payload aligned like malloc's result.
+     */
+    struct alignas(alignof(std::max_align_t)) Header {
+        std::size_t size;
+        Tag tag;
+    };
+
+    static void account(std::size_t size, Tag tag) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        byteCount.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+        tagAllocations[tag].fetch_add(1, std::memory_order_relaxed);
+
+        long long live = liveBytes[tag].fetch_add(static_cast<long long>(size), std::memory_order_relaxed) + size;
+        long long peak = peakBytes[tag].load(std::memory_order_relaxed);
+        while (live > peak && !peakBytes[tag].compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+        }
+
+        long long total = totalLive.fetch_add(static_cast<long long>(size), std::memory_order_relaxed) + size;
+        long long limit = budget.load(std::memory_order_relaxed);
+        if (limit > 0 && total > limit) {
+            budgetExceeded.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    static void unaccount(const Header *header) {
+        liveBytes[header->tag].fetch_sub(static_cast<long long>(header->size), std::memory_order_relaxed);
+        totalLive.fetch_sub(static_cast<long long>(header->size), std::memory_order_relaxed);
+    }
+
+    /* Public interface */
+
+    long long allocations() {
+        return allocationCount.load(std::memory_order_relaxed);
+    }
+
+    long long allocatedBytes() {
+        return byteCount.load(std::memory_order_relaxed);
+    }
+
+    void setBudget(long long bytes) {
+        budget.store(bytes, std::memory_order_relaxed);
+    }
+
+    void checkBudget() {
+        if (budgetExceeded.load(std::memory_order_relaxed)) {
+            output::errorMemoryBudget(budget.load(std::memory_order_relaxed));
+        }
+    }
+
+    void report(std::ostream &os) {
+        os << "===- Memory usage -===" << std::endl;
+        os << std::setw(10) << "tag" << std::setw(14) << "live" << std::setw(14) << "peak" << std::setw(12) << "allocs"
+           << std::endl;
+        for (int tag = 0; tag < NUM_TAGS; ++tag) {
+            os << std::setw(10) << tagNames[tag] << std::setw(14) << liveBytes[tag].load() << std::setw(14)
+               << peakBytes[tag].load() << std::setw(12) << tagAllocations[tag].load() << std::endl;
+        }
+    }
+
+    void *allocate(std::size_t size, Tag tag) {
+        auto *header = static_cast<Header *>(std::malloc(sizeof(Header) + size));
+        if (!header) {
+            return nullptr;
+        }
+        header->size = size;
+        header->tag = tag;
+        account(size, tag);
+        return header + 1;
+    }
+
+    void *reallocate(void *ptr, std::size_t size, Tag tag) {
+        if (!ptr) {
+            return allocate(size, tag);
+        }
+        Header *header = static_cast<Header *>(ptr) - 1;
+        Header old = *header;
+        header = static_cast<Header *>(std::realloc(header, sizeof(Header) + size));
+        if (!header) {
+            return nullptr;
+        }
+        unaccount(&old);
+        header->size = size;
+        header->tag = old.tag;
+        account(size, old.tag);
+        return header + 1;
+    }
+
+    void release(void *ptr) {
+        if (!ptr) {
+            return;
+        }
+        Header *header = static_cast<Header *>(ptr) - 1;
+        unaccount(header);
+        std::free(header);
+    }
+
+    TagScope::TagScope(Tag tag) : previous(currentTag) {
+        currentTag = tag;
+    }
+
+    TagScope::~TagScope() {
+        currentTag = previous;
+    }
+
+    static void *allocateOrThrow(std::size_t size) {
+        void *ptr = allocate(size, currentTag);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+}
+
+/* Replacements of the global allocation functions */
+
+void *operator new(std::size_t size) {
+    return memstats::allocateOrThrow(size);
+}
+
+void *operator new[](std::size_t size) {
+    return memstats::allocateOrThrow(size);
+}
+
+void operator delete(void *ptr) noexcept {
+    memstats::release(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    memstats::release(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    memstats::release(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    memstats::release(ptr);
+}
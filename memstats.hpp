@@ -0,0 +1,63 @@
+#ifndef MEMSTATS_HPP
+#define MEMSTATS_HPP
+
+#include <cstddef>
+#include <ostream>
+
+/* Allocation accounting. The global operator new/delete are replaced so every allocation is counted
+ * and attributed to the subsystem (tag) that was active when it was made.
+ */
+namespace memstats {
+
+    /* Subsystems memory is attributed to */
+    enum Tag {
+        OTHER,
+        LEXER,    // flex buffers
+        AST,      // nodes built while parsing
+        SYMBOLS,  // symbol and function tables
+        PRINTER,  // ScopePrinter buffers
+        IR,       // CFGs, dataflow results and SSA
+        NUM_TAGS
+    };
+
+    // Number of calls to operator new since the start of the program
+    long long allocations();
+
+    // Number of bytes requested from operator new since the start of the program
+    long long allocatedBytes();
+
+    // Limits live memory to the given number of bytes (0 disables). Exceeding it only sets a flag, since
+    // allocations happen anywhere, including on lexer threads; checkBudget() reports it
+    void setBudget(long long bytes);
+
+    // Aborts the compilation with a diagnostic if the budget was exceeded. Called on the main thread between
+    // phases, where exiting is safe
+    void checkBudget();
+
+    // Prints live bytes, peak live bytes and allocation count per tag
+    void report(std::ostream &os);
+
+    // malloc-style allocation functions attributed to a tag, for C code such as the flex scanner
+    void *allocate(std::size_t size, Tag tag);
+
+    void *reallocate(void *ptr, std::size_t size, Tag tag);
+
+    void release(void *ptr);
+
+    /* Attributes the allocations made by this thread in the enclosing C++ scope to a tag */
+    class TagScope {
+    private:
+        Tag previous;
+
+    public:
+        explicit TagScope(Tag tag);
+
+        ~TagScope();
+
+        TagScope(const TagScope &) = delete;
+
+        TagScope &operator=(const TagScope &) = delete;
+    };
+}
+
+#endif //MEMSTATS_HPP
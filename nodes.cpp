@@ -1,26 +1,39 @@
 #include "nodes.hpp"
+#include "trace.hpp"
+#include "literals.hpp"
 #include <string>
 #include <utility>
 
-extern int yylineno;
-
 namespace ast {
 
-    Node::Node() : line(yylineno) {}
+    Node::Node() : location(locations::table().add(locations::current)) {
+        TRACE_COUNT(NODES_ALLOCATED);
+    }
+
+    locations::Span Node::span() const {
+        return locations::table().get(location);
+    }
+
+    int Node::line() const {
+        return span().firstLine;
+    }
+
+    Num::Num(int value) : Exp(), value(value) {}
 
-    Num::Num(const char *str) : Exp(), value(std::stoi(str)) {}
+    NumB::NumB(int value) : Exp(), value(value) {}
 
-    NumB::NumB(const char *str) : Exp(), value(std::stoi(str)) {}
+    String::String(int index) : Exp(), index(index) {}
 
-    String::String(const char *str) : Exp(), value(str) {
-        // Remove the quotes
-        value = value.substr(1, value.size() - 2);
+    const std::string &String::value() const {
+        return literals::pool().get(index);
     }
 
     Bool::Bool(bool value) : Exp(), value(value) {}
 
     ID::ID(const char *str) : Exp(), value(str) {}
 
+    ID::ID(const char *str, size_t length) : Exp(), value(str, length) {}
+
     BinOp::BinOp(std::shared_ptr<Exp> left, std::shared_ptr<Exp> right, BinOpType op)
             : Exp(), left(std::move(left)), right(std::move(right)), op(op) {}
 
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include "visitor.hpp"
+#include "locations.hpp"
 
 namespace ast {
 
@@ -38,12 +39,18 @@ namespace ast {
     /* Base class for all AST nodes */
     class Node {
     public:
-        // Line number in the source code
-        int line;
+        // Index of the node's source span in locations::table()
+        int location;
 
         // Use this constructor only while parsing in bison or flex
         Node();
 
+        // Source span of the node, decoded from the location table
+        locations::Span span() const;
+
+        // First line of the node in the source code
+        int line() const;
+
         // Accept method for visitor pattern
         virtual void accept(Visitor &visitor) = 0;
     };
@@ -64,8 +71,8 @@ namespace ast {
         // Value of the number
         int value;
 
-        // Constructor that receives a C-style string that represents the number
-        explicit Num(const char *str);
+        // Constructor that receives the value, parsed by the scanner
+        explicit Num(int value);
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -78,8 +85,8 @@ namespace ast {
         // Value of the number
         int value;
 
-        // Constructor that receives a C-style (including b character) string that represents the number
-        explicit NumB(const char *str);
+        // Constructor that receives the value, parsed and range-checked by the scanner
+        explicit NumB(int value);
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -89,11 +96,14 @@ namespace ast {
     /* String literal */
     class String : public Exp {
     public:
-        // Value of the string
-        std::string value;
+        // Index of the decoded value in the string literal pool (see literals.hpp)
+        int index;
 
-        // Constructor that receives a C-style string that represents the string *including quotes*
-        explicit String(const char *str);
+        // Constructor that receives the index of the literal in the string literal pool
+        explicit String(int index);
+
+        // Decoded value of the string
+        const std::string &value() const;
 
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
@@ -123,6 +133,9 @@ namespace ast {
         // Constructor that receives a C-style string that represents the identifier
         explicit ID(const char *str);
 
+        // Constructor that receives a name that is not NUL-terminated and its length
+        ID(const char *str, size_t length);
+
         void accept(Visitor &visitor) override {
             visitor.visit(*this);
         }
@@ -450,9 +463,13 @@ namespace ast {
         std::shared_ptr<Type> return_type;
         // List of formal parameters
         std::shared_ptr<Formals> formals;
-        // Body of the function
+        // Body of the function. nullptr while it is unparsed (see rdparser::parse)
         std::shared_ptr<Statements> body;
 
+        // Tokens between the braces of an unparsed body, or -1
+        int firstBodyToken = -1;
+        int lastBodyToken = -1;
+
         // Constructor that receives the identifier, the return type, the list of formal parameters, and the body
         FuncDecl(std::shared_ptr<ID> id, std::shared_ptr<Type> return_type, std::shared_ptr<Formals> formals,
                  std::shared_ptr<Statements> body);
@@ -0,0 +1,378 @@
+#include "optimizer.hpp"
+#include <algorithm>
+#include <map>
+
+namespace optimizer {
+
+    /* Helper functions */
+
+    // Removes the edge from -> to, along with the matching phi arguments of `to`
+    static void removeEdge(ssa::Function &func, int from, int to) {
+        ssa::Block &target = func.blocks[to];
+        auto pred = std::find(target.preds.begin(), target.preds.end(), from);
+        if (pred != target.preds.end()) {
+            auto index = pred - target.preds.begin();
+            target.preds.erase(pred);
+            for (int phi : target.phis) {
+                auto &args = func.instrs[phi].args;
+                if (index < static_cast<long>(args.size())) {
+                    args.erase(args.begin() + index);
+                }
+            }
+        }
+        auto &succs = func.blocks[from].succs;
+        auto succ = std::find(succs.begin(), succs.end(), to);
+        if (succ != succs.end()) {
+            succs.erase(succ);
+        }
+    }
+
+    // Evaluates a pure instruction over constant arguments. Returns false if it cannot be folded
+    static bool fold(const ssa::Function &func, const ssa::Instr &instr, int &value) {
+        int args[2] = {0, 0};
+        if (instr.args.empty() || instr.args.size() > 2) {
+            return false;
+        }
+        for (size_t i = 0; i < instr.args.size(); ++i) {
+            const ssa::Instr &arg = func.instrs[func.resolve(instr.args[i])];
+            if (arg.op != ssa::Op::CONST) {
+                return false;
+            }
+            args[i] = arg.value;
+        }
+
+        switch (instr.op) {
+            case ssa::Op::BINOP: {
+                long long result;
+                switch (instr.sub) {
+                    case ast::BinOpType::ADD:
+                        result = static_cast<long long>(args[0]) + args[1];
+                        break;
+                    case ast::BinOpType::SUB:
+                        result = static_cast<long long>(args[0]) - args[1];
+                        break;
+                    case ast::BinOpType::MUL:
+                        result = static_cast<long long>(args[0]) * args[1];
+                        break;
+                    default:
+                        if (args[1] == 0) {
+                            return false; // Keep the runtime division-by-zero error
+                        }
+                        result = static_cast<long long>(args[0]) / args[1];
+                        break;
+                }
+                value = instr.type == ast::BuiltInType::BYTE ? static_cast<int>(result & 0xff)
+                                                             : static_cast<int>(static_cast<unsigned int>(result));
+                return true;
+            }
+            case ssa::Op::RELOP:
+                switch (instr.sub) {
+                    case ast::RelOpType::EQ:
+                        value = args[0] == args[1];
+                        break;
+                    case ast::RelOpType::NE:
+                        value = args[0] != args[1];
+                        break;
+                    case ast::RelOpType::LT:
+                        value = args[0] < args[1];
+                        break;
+                    case ast::RelOpType::GT:
+                        value = args[0] > args[1];
+                        break;
+                    case ast::RelOpType::LE:
+                        value = args[0] <= args[1];
+                        break;
+                    default:
+                        value = args[0] >= args[1];
+                        break;
+                }
+                return true;
+            case ssa::Op::NOT:
+                value = !args[0];
+                return true;
+            case ssa::Op::CAST:
+                value = instr.type == ast::BuiltInType::BYTE ? (args[0] & 0xff) : args[0];
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // Live blocks reachable from the entry, in reverse post-order
+    static std::vector<int> reversePostOrder(const ssa::Function &func) {
+        std::vector<int> postOrder;
+        std::vector<bool> visited(func.blocks.size(), false);
+        std::vector<std::pair<int, size_t>> stack{{cfg::FunctionCFG::ENTRY, 0}};
+        visited[cfg::FunctionCFG::ENTRY] = true;
+        while (!stack.empty()) {
+            int block = stack.back().first;
+            size_t next = stack.back().second++;
+            const auto &succs = func.blocks[block].succs;
+            if (next < succs.size()) {
+                if (!visited[succs[next]]) {
+                    visited[succs[next]] = true;
+                    stack.emplace_back(succs[next], 0);
+                }
+            } else {
+                postOrder.push_back(block);
+                stack.pop_back();
+            }
+        }
+        return std::vector<int>(postOrder.rbegin(), postOrder.rend());
+    }
+
+    /* Dominator tree, numbered so that a dominates b iff pre[a] <= pre[b] and post[b] <= post[a] */
+    struct Dominators {
+        std::vector<int> pre;
+        std::vector<int> post;
+
+        Dominators(const ssa::Function &func, const std::vector<int> &rpo)
+                : pre(func.blocks.size(), -1), post(func.blocks.size(), -1) {
+            std::vector<int> order(func.blocks.size(), -1);
+            for (size_t i = 0; i < rpo.size(); ++i) {
+                order[rpo[i]] = static_cast<int>(i);
+            }
+
+            // Cooper, Harvey and Kennedy's iterative algorithm
+            std::vector<int> idom(func.blocks.size(), -1);
+            idom[rpo[0]] = rpo[0];
+            for (bool changed = true; changed;) {
+                changed = false;
+                for (size_t i = 1; i < rpo.size(); ++i) {
+                    int newIdom = -1;
+                    for (int pred : func.blocks[rpo[i]].preds) {
+                        if (order[pred] < 0 || idom[pred] < 0) {
+                            continue;
+                        }
+                        if (newIdom < 0) {
+                            newIdom = pred;
+                            continue;
+                        }
+                        int a = pred, b = newIdom;
+                        while (a != b) {
+                            while (order[a] > order[b]) {
+                                a = idom[a];
+                            }
+                            while (order[b] > order[a]) {
+                                b = idom[b];
+                            }
+                        }
+                        newIdom = a;
+                    }
+                    if (idom[rpo[i]] != newIdom) {
+                        idom[rpo[i]] = newIdom;
+                        changed = true;
+                    }
+                }
+            }
+
+            std::vector<std::vector<int>> children(func.blocks.size());
+            for (size_t i = 1; i < rpo.size(); ++i) {
+                children[idom[rpo[i]]].push_back(rpo[i]);
+            }
+            int counter = 0;
+            std::vector<std::pair<int, size_t>> stack{{rpo[0], 0}};
+            pre[rpo[0]] = counter++;
+            while (!stack.empty()) {
+                int block = stack.back().first;
+                size_t next = stack.back().second++;
+                if (next < children[block].size()) {
+                    int child = children[block][next];
+                    pre[child] = counter++;
+                    stack.emplace_back(child, 0);
+                } else {
+                    post[block] = counter++;
+                    stack.pop_back();
+                }
+            }
+        }
+
+        bool dominates(int a, int b) const {
+            return pre[a] <= pre[b] && post[b] <= post[a];
+        }
+    };
+
+    /* Passes */
+
+    int removeUnreachableBlocks(ssa::Function &func) {
+        int before = func.numLiveInstrs();
+        func.canonicalize();
+
+        // Branches on constants become jumps
+        for (size_t b = 0; b < func.blocks.size(); ++b) {
+            ssa::Block &block = func.blocks[b];
+            if (block.dead || block.instrs.empty()) {
+                continue;
+            }
+            ssa::Instr &last = func.instrs[block.instrs.back()];
+            if (last.dead || last.op != ssa::Op::BRANCH || block.succs.size() != 2) {
+                continue;
+            }
+            const ssa::Instr &cond = func.instrs[last.args[0]];
+            if (cond.op != ssa::Op::CONST) {
+                continue;
+            }
+            last.dead = true;
+            removeEdge(func, static_cast<int>(b), cond.value ? block.succs[1] : block.succs[0]);
+        }
+
+        // Blocks no longer reachable from the entry are deleted
+        std::vector<bool> reachable(func.blocks.size(), false);
+        for (int block : reversePostOrder(func)) {
+            reachable[block] = true;
+        }
+        for (size_t b = 0; b < func.blocks.size(); ++b) {
+            ssa::Block &block = func.blocks[b];
+            if (block.dead || reachable[b]) {
+                continue;
+            }
+            while (!block.succs.empty()) {
+                removeEdge(func, static_cast<int>(b), block.succs.back());
+            }
+            for (const auto *list : {&block.phis, &block.instrs}) {
+                for (int v : *list) {
+                    func.instrs[v].dead = true;
+                }
+            }
+            block = ssa::Block{{}, {}, {}, {}, true};
+        }
+        return before - func.numLiveInstrs();
+    }
+
+    int propagateConstants(ssa::Function &func) {
+        int folded = 0;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (ssa::Instr &instr : func.instrs) {
+                int value;
+                if (instr.dead || instr.op == ssa::Op::CONST || !fold(func, instr, value)) {
+                    continue;
+                }
+                instr.op = ssa::Op::CONST;
+                instr.value = value;
+                instr.args.clear();
+                folded++;
+                changed = true;
+            }
+        }
+        return folded;
+    }
+
+    int propagateCopies(ssa::Function &func) {
+        int removed = 0;
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (ssa::Block &block : func.blocks) {
+                for (int phi : block.phis) {
+                    ssa::Instr &instr = func.instrs[phi];
+                    if (instr.dead) {
+                        continue;
+                    }
+                    int same = -1;
+                    bool trivial = true;
+                    for (int arg : instr.args) {
+                        arg = func.resolve(arg);
+                        if (arg == phi || arg == same) {
+                            continue;
+                        }
+                        if (same >= 0) {
+                            trivial = false;
+                            break;
+                        }
+                        same = arg;
+                    }
+                    if (trivial && same >= 0) {
+                        func.replace(phi, same);
+                        removed++;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        func.canonicalize();
+        return removed;
+    }
+
+    int numberValues(ssa::Function &func) {
+        func.canonicalize();
+        std::vector<int> rpo = reversePostOrder(func);
+        Dominators dominators(func, rpo);
+
+        int removed = 0;
+        std::map<std::vector<int>, std::vector<int>> leaders;
+        std::vector<int> key;
+        for (int b : rpo) {
+            for (const auto *list : {&func.blocks[b].phis, &func.blocks[b].instrs}) {
+                for (int v : *list) {
+                    ssa::Instr &instr = func.instrs[v];
+                    if (instr.dead || instr.op == ssa::Op::PARAM || instr.op == ssa::Op::STRING ||
+                        func.hasSideEffects(instr) || (instr.op == ssa::Op::PHI && instr.args.empty())) {
+                        continue;
+                    }
+
+                    key.assign({static_cast<int>(instr.op), instr.sub, static_cast<int>(instr.type), instr.value,
+                                instr.op == ssa::Op::PHI ? b : -1});
+                    size_t firstArg = key.size();
+                    for (int arg : instr.args) {
+                        key.push_back(func.resolve(arg));
+                    }
+                    bool commutative = (instr.op == ssa::Op::BINOP && (instr.sub == ast::BinOpType::ADD ||
+                                                                        instr.sub == ast::BinOpType::MUL)) ||
+                                       (instr.op == ssa::Op::RELOP && (instr.sub == ast::RelOpType::EQ ||
+                                                                        instr.sub == ast::RelOpType::NE));
+                    if (commutative) {
+                        std::sort(key.begin() + firstArg, key.end());
+                    }
+
+                    auto &candidates = leaders[key];
+                    int leader = -1;
+                    for (int candidate : candidates) {
+                        if (dominators.dominates(func.instrs[candidate].block, b)) {
+                            leader = candidate;
+                            break;
+                        }
+                    }
+                    if (leader >= 0) {
+                        func.replace(v, leader);
+                        removed++;
+                    } else {
+                        candidates.push_back(v);
+                    }
+                }
+            }
+        }
+        func.canonicalize();
+        return removed;
+    }
+
+    int eliminateDeadCode(ssa::Function &func) {
+        func.canonicalize();
+        std::vector<bool> used(func.instrs.size(), false);
+        std::vector<int> worklist;
+        for (size_t v = 0; v < func.instrs.size(); ++v) {
+            if (!func.instrs[v].dead && func.hasSideEffects(func.instrs[v])) {
+                used[v] = true;
+                worklist.push_back(static_cast<int>(v));
+            }
+        }
+        while (!worklist.empty()) {
+            int v = worklist.back();
+            worklist.pop_back();
+            for (int arg : func.instrs[v].args) {
+                if (!used[arg]) {
+                    used[arg] = true;
+                    worklist.push_back(arg);
+                }
+            }
+        }
+
+        int removed = 0;
+        for (size_t v = 0; v < func.instrs.size(); ++v) {
+            if (!func.instrs[v].dead && !used[v]) {
+                func.instrs[v].dead = true;
+                removed++;
+            }
+        }
+        return removed;
+    }
+}
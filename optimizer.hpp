@@ -0,0 +1,24 @@
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include "ssa.hpp"
+
+namespace optimizer {
+
+    // Folds branches on constant conditions and deletes blocks that become unreachable
+    int removeUnreachableBlocks(ssa::Function &func);
+
+    // Evaluates instructions whose arguments are all constants
+    int propagateConstants(ssa::Function &func);
+
+    // Removes phis whose arguments are all the same value (or the phi itself)
+    int propagateCopies(ssa::Function &func);
+
+    // Replaces instructions computing a value already available in a dominating instruction
+    int numberValues(ssa::Function &func);
+
+    // Deletes instructions whose values are never used and which have no side effects
+    int eliminateDeadCode(ssa::Function &func);
+}
+
+#endif //OPTIMIZER_HPP
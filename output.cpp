@@ -1,26 +1,11 @@
 #include "output.hpp"
+#include "trace.hpp"
+#include "perfcounters.hpp"
+#include "memstats.hpp"
+#include "types.hpp"
 #include <iostream>
 
 namespace output {
-    /* Helper functions */
-
-    static std::string toString(ast::BuiltInType type) {
-        switch (type) {
-            case ast::BuiltInType::INT:
-                return "int";
-            case ast::BuiltInType::BOOL:
-                return "bool";
-            case ast::BuiltInType::BYTE:
-                return "byte";
-            case ast::BuiltInType::VOID:
-                return "void";
-            case ast::BuiltInType::STRING:
-                return "string";
-            default:
-                return "unknown";
-        }
-    }
-
     /* Error handling functions */
 
     void errorLex(int lineno) {
@@ -66,7 +51,7 @@ namespace output {
     void errorPrototypeMismatch(int lineno, const std::string &id, std::vector<std::string> &paramTypes) {
         std::cout << "line " << lineno << ": prototype mismatch, function " << id << " expects parameters (";
 
-        for (int i = 0; i < paramTypes.size(); ++i) {
+        for (size_t i = 0; i < paramTypes.size(); ++i) {
             std::cout << paramTypes[i];
             if (i != paramTypes.size() - 1)
                 std::cout << ",";
@@ -96,9 +81,39 @@ namespace output {
         exit(0);
     }
 
+    void errorNumTooLarge(int lineno, const std::string &literal) {
+        std::cout << "line " << lineno << ": integer literal " << literal << " out of range" << std::endl;
+        exit(0);
+    }
+
+    void errorMemoryBudget(long long budget) {
+        std::cout << "memory budget of " << budget << " bytes exceeded, compilation aborted" << std::endl;
+        exit(0);
+    }
+
+    void errorInterface(const std::string &path) {
+        std::cout << "interface file " << path << " is missing or malformed, compilation aborted" << std::endl;
+        exit(0);
+    }
+
+    void errorImportConflict(const std::string &id) {
+        std::cout << "function " << id << " is imported with conflicting signatures" << std::endl;
+        exit(0);
+    }
+
+    /* Warning functions */
+
+    void warnUnassigned(int lineno, const std::string &id) {
+        std::cerr << "line " << lineno << ": warning: variable " << id << " may be used before being assigned" << std::endl;
+    }
+
+    void warnUnused(int lineno, const std::string &id) {
+        std::cerr << "line " << lineno << ": warning: variable " << id << " is never used" << std::endl;
+    }
+
     /* ScopePrinter class */
 
-    ScopePrinter::ScopePrinter() : indentLevel(0) {}
+    ScopePrinter::ScopePrinter() : indentLevel(0), packedOffsets(nullptr) {}
 
     std::string ScopePrinter::indent() const {
         std::string result;
@@ -108,38 +123,76 @@ namespace output {
         return result;
     }
 
+    int ScopePrinter::offsetOf(const Line &line) const {
+        if (packedOffsets && line.decl) {
+            auto it = packedOffsets->find(line.decl);
+            if (it != packedOffsets->end()) {
+                return it->second;
+            }
+        }
+        return line.offset;
+    }
+
     void ScopePrinter::beginScope() {
+        memstats::TagScope tag(memstats::PRINTER);
         indentLevel++;
-        buffer << indent() << "---begin scope---" << std::endl;
+        lines.push_back({indent() + "---begin scope---", nullptr, 0, false});
     }
 
     void ScopePrinter::endScope() {
-        buffer << indent() << "---end scope---" << std::endl;
+        memstats::TagScope tag(memstats::PRINTER);
+        lines.push_back({indent() + "---end scope---", nullptr, 0, false});
         indentLevel--;
     }
 
     void ScopePrinter::emitVar(const std::string &id, const ast::BuiltInType &type, int offset) {
-        buffer << indent() << id << " " << toString(type) << " " << offset << std::endl;
+        memstats::TagScope tag(memstats::PRINTER);
+        lines.push_back({indent() + id + " " + types::name(type) + " ", nullptr, offset, true});
+    }
+
+    void ScopePrinter::emitVar(const ast::Node &decl, const std::string &id, const ast::BuiltInType &type, int offset) {
+        memstats::TagScope tag(memstats::PRINTER);
+        lines.push_back({indent() + id + " " + types::name(type) + " ", &decl, offset, true});
+    }
+
+    void ScopePrinter::usePackedOffsets(const std::unordered_map<const ast::Node *, int> *offsets) {
+        packedOffsets = offsets;
     }
 
     void ScopePrinter::emitFunc(const std::string &id, const ast::BuiltInType &returnType,
                                 const std::vector<ast::BuiltInType> &paramTypes) {
+        memstats::TagScope tag(memstats::PRINTER);
         globalsBuffer << id << " " << "(";
 
-        for (int i = 0; i < paramTypes.size(); ++i) {
-            globalsBuffer << toString(paramTypes[i]);
+        for (size_t i = 0; i < paramTypes.size(); ++i) {
+            globalsBuffer << types::name(paramTypes[i]);
             if (i != paramTypes.size() - 1)
                 globalsBuffer << ",";
         }
 
-        globalsBuffer << ")" << " -> " << toString(returnType) << std::endl;
+        globalsBuffer << ")" << " -> " << types::name(returnType) << std::endl;
     }
 
     std::ostream &operator<<(std::ostream &os, const ScopePrinter &printer) {
+        perf::Phase phase(perf::PRINT);
+        memstats::TagScope tag(memstats::PRINTER);
+        std::string globals = printer.globalsBuffer.str();
+        std::stringstream buffer;
+        for (const auto &line : printer.lines) {
+            buffer << line.text;
+            if (line.variable) {
+                buffer << printer.offsetOf(line);
+            }
+            buffer << std::endl;
+        }
+        std::string scopes = buffer.str();
         os << "---begin global scope---" << std::endl;
-        os << printer.globalsBuffer.str();
-        os << printer.buffer.str();
+        os << globals;
+        os << scopes;
         os << "---end global scope---" << std::endl;
+        // sizeof counts the terminating NUL, standing in for each header's newline
+        TRACE_ADD(BYTES_PRINTED, sizeof("---begin global scope---") + globals.size() + scopes.size() +
+                                 sizeof("---end global scope---"));
         return os;
     }
 }
@@ -4,7 +4,7 @@
 #include <vector>
 #include <string>
 #include <sstream>
-#include "visitor.hpp"
+#include <unordered_map>
 #include "nodes.hpp"
 
 namespace output {
@@ -36,17 +36,46 @@ namespace output {
 
     void errorByteTooLarge(int lineno, int value);
 
+    void errorNumTooLarge(int lineno, const std::string &literal);
+
+    void errorMemoryBudget(long long budget);
+
+    void errorInterface(const std::string &path);
+
+    void errorImportConflict(const std::string &id);
+
+    /* Warning functions. Warnings go to stderr and do not stop the compilation */
+
+    void warnUnassigned(int lineno, const std::string &id);
+
+    void warnUnused(int lineno, const std::string &id);
+
     /* ScopePrinter class
      * This class is used to print scopes in a human-readable format.
      */
     class ScopePrinter {
     private:
+        // A line of the nested scopes. The offset of a variable line is only printed by operator<<, so packed
+        // offsets can be provided after the scopes were emitted
+        struct Line {
+            std::string text;
+            // Declaration of a variable line, or nullptr
+            const ast::Node *decl;
+            int offset;
+            bool variable;
+        };
+
         std::stringstream globalsBuffer;
-        std::stringstream buffer;
+        std::vector<Line> lines;
         int indentLevel;
+        // Packed frame offsets keyed by declaration, or nullptr to print the offsets given to emitVar
+        const std::unordered_map<const ast::Node *, int> *packedOffsets;
 
         std::string indent() const;
 
+        // Offset of a variable line, the packed one if the frame layout provided one
+        int offsetOf(const Line &line) const;
+
     public:
         ScopePrinter();
 
@@ -56,6 +85,12 @@ namespace output {
 
         void emitVar(const std::string &id, const ast::BuiltInType &type, int offset);
 
+        // Same as above, but prints the packed offset of the declaration if one is provided
+        void emitVar(const ast::Node &decl, const std::string &id, const ast::BuiltInType &type, int offset);
+
+        // Makes the printed variables show the offsets chosen by the frame layout, even those already emitted
+        void usePackedOffsets(const std::unordered_map<const ast::Node *, int> *offsets);
+
         void emitFunc(const std::string &id, const ast::BuiltInType &returnType,
                       const std::vector<ast::BuiltInType> &paramTypes);
 
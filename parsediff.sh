@@ -0,0 +1,119 @@
+#!/bin/bash
+# Differential test of the bison parser against --parser=pratt on generated programs, comparing the output
+# of ./hw3 --dump-ast: the syntax tree with node spans, or the line of the first lexical or syntax error.
+# Rounds mutate the program (dropping, duplicating or inserting tokens, some of them lexical errors) with
+# probability $3 per line. Fixed cases follow: a long program and one ending in the middle of a function.
+# Usage: ./parsediff.sh [rounds] [functions] [mutation rate]
+
+gen_program() {
+    # $2 functions of random statements and deeply nested expressions, seeded with $1, with tokens
+    # mutated on a fraction $3 of the lines
+    awk -v seed="$1" -v funcs="$2" -v rate="$3" '
+    function pick(list,    items, n) {
+        n = split(list, items, " ")
+        return items[int(rand() * n) + 1]
+    }
+    function expr(depth,    r) {
+        r = rand()
+        if (depth <= 0 || r < 0.25) {
+            r = rand()
+            if (r < 0.4) return pick("a b x y")
+            if (r < 0.6) return int(rand() * 1000)
+            if (r < 0.7) return int(rand() * 256) "b"
+            if (r < 0.8) return pick("true false")
+            if (r < 0.9) return "\"s" int(rand() * 10) "\""
+            return "f ( )"
+        }
+        if (r < 0.6) return expr(depth - 1) " " pick("+ - * / and or == != < <= > >=") " " expr(depth - 1)
+        if (r < 0.7) return "( " expr(depth - 1) " )"
+        if (r < 0.78) return "( " pick("int byte bool") " ) " expr(depth - 1)
+        if (r < 0.86) return "not " expr(depth - 1)
+        if (r < 0.93) return "g ( " expr(depth - 1) " , " expr(depth - 1) " )"
+        return "h ( " expr(depth - 1) " )"
+    }
+    function statement(depth,    r) {
+        r = rand()
+        if (depth > 0 && r < 0.12) return "if ( " expr(3) " ) " statement(depth - 1)
+        if (depth > 0 && r < 0.22) return "if ( " expr(3) " ) " statement(depth - 1) " else " statement(depth - 1)
+        if (depth > 0 && r < 0.30) return "while ( " expr(3) " ) " statement(depth - 1)
+        if (depth > 0 && r < 0.40) return "{ " statement(depth - 1) "\n" statement(depth - 1) " }"
+        if (r < 0.55) return pick("int byte bool") " " pick("a b x y") " = " expr(4) " ;"
+        if (r < 0.60) return pick("int byte bool") " " pick("a b x y") " ;"
+        if (r < 0.78) return pick("a b x y") " = " expr(4) " ;"
+        if (r < 0.85) return "f ( " expr(3) " ) ;"
+        if (r < 0.90) return "return " expr(3) " ;"
+        if (r < 0.93) return "return ;"
+        return pick("break continue") " ;"
+    }
+    function mutate(line,    words, n, i, out, r) {
+        n = split(line, words, " ")
+        out = ""
+        for (i = 1; i <= n; i++) {
+            r = rand()
+            if (r < 0.1) continue
+            out = out " " words[i]
+            if (r < 0.2) out = out " " words[i]
+            else if (r < 0.3) out = out " " pick("( ) { } ; , = + not else int void return 7 300b @")
+        }
+        return out
+    }
+    function emit(text,    lines, n, i) {
+        n = split(text, lines, "\n")
+        for (i = 1; i <= n; i++) {
+            print (rand() < rate ? mutate(lines[i]) : lines[i])
+        }
+    }
+    BEGIN {
+        srand(seed)
+        for (k = 0; k < funcs; k++) {
+            emit(pick("int byte bool void") " fn" k " ( " (rand() < 0.5 ? "" : "int a , byte b") " ) {")
+            count = int(rand() * 6) + 1
+            for (s = 0; s < count; s++) {
+                emit("    " statement(3))
+            }
+            emit("}")
+        }
+    }'
+}
+
+rounds="${1:-50}"
+funcs="${2:-20}"
+rate="${3:-0.02}"
+input="parsediff.in"
+failed=0
+
+# Parses $input with both parsers and reports a difference under the name $1
+compare() {
+    ./hw3 --dump-ast < "$input" > parsediff.bison
+    ./hw3 --dump-ast --parser=pratt < "$input" > parsediff.pratt
+    if ! cmp -s parsediff.bison parsediff.pratt; then
+        echo "$1: outputs differ, input kept in parsediff.fail.$2"
+        diff parsediff.bison parsediff.pratt | head -5
+        cp "$input" "parsediff.fail.$2"
+        failed=1
+    fi
+}
+
+for ((round = 1; round <= rounds; round++)); do
+    # Every fifth round is left unmutated, so complete trees are compared too
+    if ((round % 5 == 0)); then
+        gen_program "$round" "$funcs" 0 > "$input"
+    else
+        gen_program "$round" "$funcs" "$rate" > "$input"
+    fi
+    compare "Round ${round}" "${round}"
+done
+
+# More functions than bison's initial stack has entries, which only fits with left-recursive lists
+gen_program 0 250 0 > "$input"
+compare "250 functions" "long"
+# Input ending inside a function, so the syntax error is at the end of input, reported on the last line
+gen_program 0 3 0 | head -n -1 > "$input"
+printf '\n\n' >> "$input"
+compare "Truncated input" "eof"
+
+rm -f "$input" parsediff.bison parsediff.pratt
+if [ "$failed" -eq 0 ]; then
+    echo "All ${rounds} rounds and the fixed cases identical"
+fi
+exit "$failed"
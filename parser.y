@@ -2,13 +2,20 @@
 
 #include "nodes.hpp"
 #include "output.hpp"
+#include "trace.hpp"
+#include "locations.hpp"
+#include "tokens.hpp"
 #include <memory>
 #include <iostream>
 #include <stdlib.h>
 
-// Bison declarations
-extern int yylineno;
-extern int yylex();
+extern YYLTYPE yylloc;
+
+// Tokens come from the buffer filled by the scanning stage (see tokens.hpp)
+static int bufferedLex() {
+    return tokens::next(yylloc);
+}
+#define yylex bufferedLex
 
 void yyerror(const char*);
 
@@ -21,8 +28,32 @@ using std::dynamic_pointer_cast;
 #define YYERROR_VERBOSE 1
 #define YYDEBUG 1
 
+// Bison's default span computation, which also publishes the span of the rule being reduced
+// so that the nodes built by its action record it
+#define YYLLOC_DEFAULT(Current, Rhs, N)                                          \
+    ((Current) = (N) ? tokens::reduce(YYRHSLOC(Rhs, 1), YYRHSLOC(Rhs, N))        \
+                     : tokens::reduceEmpty(YYRHSLOC(Rhs, 0)))
+
+// The semantic values are shared pointers, which bison cannot move to a larger stack, so the stack is
+// allocated at the size it would otherwise grow to. With yyoverflow defined bison does not try to grow
+// it, and a parse nesting deeper than that reports memory exhaustion through yyerror, as a syntax error.
+// The lists are left recursive, so only nesting uses up the stack
+#define YYINITDEPTH 10000
+#define yyoverflow(...) YYNOMEM
+
 %}
 
+%code requires {
+#include "tokens.hpp"
+}
+
+%locations
+
+// Before the first token: an empty rule reduced there spans no tokens, from index 0
+%initial-action {
+    @$ = {1, 1, 1, 1, 0, -1};
+}
+
 %token ID VOID BOOL BYTE INT STRING
 %nonassoc LOWER_THAN_ELSE
 %nonassoc ELSE
@@ -62,9 +93,9 @@ Funcs:
     /*epsilon*/ {
         $$ = std::make_shared<ast::Funcs>();
     }
-    | FuncDecl Funcs {
-        auto funcs = dynamic_pointer_cast<ast::Funcs>($2);
-        funcs->push_front(dynamic_pointer_cast<ast::FuncDecl>($1));
+    | Funcs FuncDecl {
+        auto funcs = dynamic_pointer_cast<ast::Funcs>($1);
+        funcs->push_back(dynamic_pointer_cast<ast::FuncDecl>($2));
         $$ = funcs;
     }
 ;
@@ -72,7 +103,7 @@ Funcs:
 FuncDecl:
     RetType ID LPAREN Formals RPAREN LBRACE Statements RBRACE {
         $$ = std::make_shared<ast::FuncDecl>(
-            dynamic_pointer_cast<ast::ID>($2),
+            dynamic_pointer_cast<ast::ID>(tokens::leaf(@2)),
             dynamic_pointer_cast<ast::Type>($1),
             dynamic_pointer_cast<ast::Formals>($4),
             dynamic_pointer_cast<ast::Statements>($7)
@@ -101,12 +132,12 @@ Formals:
 FormalsList:
     FormalDecl {
         auto formals = make_shared<ast::Formals>();
-        formals->push_front(dynamic_pointer_cast<ast::Formal>($1));
+        formals->push_back(dynamic_pointer_cast<ast::Formal>($1));
         $$ = formals;
     }
-    | FormalDecl COMMA FormalsList {
-        auto formals = dynamic_pointer_cast<ast::Formals>($3);
-        formals->push_front(dynamic_pointer_cast<ast::Formal>($1));
+    | FormalsList COMMA FormalDecl {
+        auto formals = dynamic_pointer_cast<ast::Formals>($1);
+        formals->push_back(dynamic_pointer_cast<ast::Formal>($3));
         $$ = formals;
     }
 ;
@@ -114,7 +145,7 @@ FormalsList:
 FormalDecl:
     Type ID {
         $$ = std::make_shared<ast::Formal>(
-            dynamic_pointer_cast<ast::ID>($2),
+            dynamic_pointer_cast<ast::ID>(tokens::leaf(@2)),
             dynamic_pointer_cast<ast::Type>($1)
         );
     }
@@ -136,13 +167,13 @@ Statements:
 Statement:
     LBRACE Statements RBRACE { $$ = $2; }
     | Type ID SC { $$ = std::make_shared<ast::VarDecl>(
-                        dynamic_pointer_cast<ast::ID>($2),
+                        dynamic_pointer_cast<ast::ID>(tokens::leaf(@2)),
                         dynamic_pointer_cast<ast::Type>($1)); }
     | Type ID ASSIGN Exp SC { $$ = std::make_shared<ast::VarDecl>(
-                        dynamic_pointer_cast<ast::ID>($2),
+                        dynamic_pointer_cast<ast::ID>(tokens::leaf(@2)),
                         dynamic_pointer_cast<ast::Type>($1),
                         dynamic_pointer_cast<ast::Exp>($4)); }
-    | ID ASSIGN Exp SC { std::shared_ptr<ast::ID> id = dynamic_pointer_cast<ast::ID>($1);
+    | ID ASSIGN Exp SC { std::shared_ptr<ast::ID> id = dynamic_pointer_cast<ast::ID>(tokens::leaf(@1));
                           std::shared_ptr<ast::Exp> exp = dynamic_pointer_cast<ast::Exp>($3);
                           $$ = std::make_shared<ast::Assign>(id, exp); }
     | Call SC { $$ = $1; }
@@ -184,15 +215,15 @@ IfWithElse:
 ;
 
 Call:
-    ID LPAREN ExpList RPAREN {$$ = std::make_shared<ast::Call>(dynamic_pointer_cast<ast::ID>($1), dynamic_pointer_cast<ast::ExpList>($3));}
-    | ID LPAREN RPAREN {$$ = std::make_shared<ast::Call>(dynamic_pointer_cast<ast::ID>($1));}
+    ID LPAREN ExpList RPAREN {$$ = std::make_shared<ast::Call>(dynamic_pointer_cast<ast::ID>(tokens::leaf(@1)), dynamic_pointer_cast<ast::ExpList>($3));}
+    | ID LPAREN RPAREN {$$ = std::make_shared<ast::Call>(dynamic_pointer_cast<ast::ID>(tokens::leaf(@1)));}
 ;
 
 ExpList:
     Exp {$$ = std::make_shared<ast::ExpList>(dynamic_pointer_cast<ast::Exp>($1));}
-    | Exp COMMA ExpList {
-            auto expList = dynamic_pointer_cast<ast::ExpList>($3);
-            expList->push_front(dynamic_pointer_cast<ast::Exp>($1));
+    | ExpList COMMA Exp {
+            auto expList = dynamic_pointer_cast<ast::ExpList>($1);
+            expList->push_back(dynamic_pointer_cast<ast::Exp>($3));
             $$ = expList;
         }
 ;
@@ -209,11 +240,11 @@ Exp:
     | Exp SUB Exp   {$$ = std::make_shared<ast::BinOp>(dynamic_pointer_cast<ast::Exp>($1), dynamic_pointer_cast<ast::Exp>($3), ast::BinOpType::SUB);}
     | Exp MUL Exp   {$$ = std::make_shared<ast::BinOp>(dynamic_pointer_cast<ast::Exp>($1), dynamic_pointer_cast<ast::Exp>($3), ast::BinOpType::MUL);}
     | Exp DIV Exp   {$$ = std::make_shared<ast::BinOp>(dynamic_pointer_cast<ast::Exp>($1), dynamic_pointer_cast<ast::Exp>($3), ast::BinOpType::DIV);}
-    | ID            {$$ = $1;}
+    | ID            {$$ = tokens::leaf(@1);}
     | Call          {$$ = $1;}
-    | NUM           {$$ = $1;}
-    | NUM_B         {$$ = $1;}
-    | STRING        {$$ = $1;}
+    | NUM           {$$ = tokens::leaf(@1);}
+    | NUM_B         {$$ = tokens::leaf(@1);}
+    | STRING        {$$ = tokens::leaf(@1);}
     | TRUE          {$$ = std::make_shared<ast::Bool>(true);}
     | FALSE         {$$ = std::make_shared<ast::Bool>(false);}
     | NOT Exp       {$$ = std::make_shared<ast::Not>(dynamic_pointer_cast<ast::Exp>($2));}
@@ -234,6 +265,6 @@ Exp:
 
 %%
 
-void yyerror(const char *s) {
-    output::errorSyn(yylineno);
+void yyerror(const char *) {
+    output::errorSyn(yylloc.first_line);
 }
\ No newline at end of file
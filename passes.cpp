@@ -0,0 +1,212 @@
+#include "passes.hpp"
+#include "memstats.hpp"
+#include "optimizer.hpp"
+#include "semantic.hpp"
+#include "trace.hpp"
+#include "perfcounters.hpp"
+#include "rdparser.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+namespace passes {
+
+    /* PassManager implementation */
+
+    void PassManager::add(Pass pass) {
+        byName[pass.name] = registry.size();
+        registry.push_back(std::move(pass));
+    }
+
+    bool PassManager::has(const std::string &name) const {
+        return byName.count(name) != 0;
+    }
+
+    void PassManager::invalidate(const std::string &name) {
+        if (valid.erase(name) == 0) {
+            return;
+        }
+        for (const Pass &pass : registry) {
+            for (const std::string &dependency : pass.dependencies) {
+                if (dependency == name) {
+                    invalidate(pass.name);
+                }
+            }
+        }
+    }
+
+    void PassManager::require(const std::string &name, Context &context) {
+        if (valid.count(name) == 0) {
+            run(name, context);
+        }
+    }
+
+    void PassManager::run(const std::string &name, Context &context) {
+        const Pass &pass = registry[byName.at(name)];
+        for (const std::string &dependency : pass.dependencies) {
+            require(dependency, context);
+        }
+        TRACE_SCOPE(pass.name.c_str());
+
+        // A re-run analysis replaces its result, so whatever was computed from the old one is stale. Transforms only
+        // rewrite the SSA functions in place, and no analysis is computed from those, so they make nothing stale
+        invalidate(pass.name);
+
+        // The semantic pass tags its own allocations (symbols, printer); everything else builds IR
+        memstats::TagScope tag(pass.name == "semantic" ? memstats::OTHER : memstats::IR);
+        long long allocations = memstats::allocations();
+        long long bytes = memstats::allocatedBytes();
+        auto start = std::chrono::steady_clock::now();
+        pass.run(context);
+        memstats::checkBudget();
+        auto end = std::chrono::steady_clock::now();
+        timings.push_back(Timing{pass.name,
+                                 std::chrono::duration_cast<std::chrono::microseconds>(end - start).count(),
+                                 memstats::allocations() - allocations, memstats::allocatedBytes() - bytes});
+        if (pass.kind == Kind::ANALYSIS) {
+            valid.insert(pass.name);
+        }
+    }
+
+    void PassManager::runPipeline(const std::vector<std::string> &pipeline, Context &context) {
+        for (const std::string &name : pipeline) {
+            run(name, context);
+        }
+    }
+
+    void PassManager::printTimings(std::ostream &os) const {
+        Timing total{"total", 0, 0, 0};
+        os << "===- Pass execution timing report -===" << std::endl;
+        os << std::setw(12) << "wall(us)" << std::setw(12) << "allocs" << std::setw(14) << "bytes" << "  pass"
+           << std::endl;
+        for (const Timing &timing : timings) {
+            os << std::setw(12) << timing.micros << std::setw(12) << timing.allocations << std::setw(14)
+               << timing.bytes << "  " << timing.pass << std::endl;
+            total.micros += timing.micros;
+            total.allocations += timing.allocations;
+            total.bytes += timing.bytes;
+        }
+        os << std::setw(12) << total.micros << std::setw(12) << total.allocations << std::setw(14) << total.bytes
+           << "  " << total.pass << std::endl;
+    }
+
+    /* Standard passes */
+
+    // Wraps an SSA optimization as a pass over every function, counting removed instructions
+    static Pass ssaPass(const std::string &name, int (*transform)(ssa::Function &)) {
+        return Pass{name, Kind::TRANSFORM, {"ssa"}, [name, transform](Context &context) {
+            for (ssa::Function &func : context.functions) {
+                int before = func.numLiveInstrs();
+                transform(func);
+                context.counters[name + ".removed"] += before - func.numLiveInstrs();
+            }
+        }};
+    }
+
+    void registerStandardPasses(PassManager &manager) {
+        manager.add(Pass{"bodies", Kind::ANALYSIS, {}, [](Context &context) {
+            for (const auto &func : context.program->funcs) {
+                if (!func->body) {
+                    rdparser::parseBody(*func);
+                    context.counters["bodies.parsed"]++;
+                }
+            }
+        }});
+
+        manager.add(Pass{"signatures", Kind::TRANSFORM, {}, [](Context &context) {
+            FunctionSymbolTable funcTab;
+            output::ScopePrinter printer;
+            output::populateFunctionTable(funcTab, printer, &context.imports, *context.program);
+            const FunctionSymbolTable::FunctionEntry *main = funcTab.lookupFunction("main");
+            if (!main || main->returnType != ast::BuiltInType::VOID || main->params.size != 0) {
+                output::errorMainMissing();
+            }
+            context.scopes = std::move(printer);
+        }});
+
+        manager.add(Pass{"cfg", Kind::ANALYSIS, {"bodies"}, [](Context &context) {
+            context.graphs = cfg::buildAll(*context.program);
+            for (const auto &graph : context.graphs) {
+                context.counters["cfg.blocks"] += graph.numBlocks();
+                context.counters["cfg.instrs"] += static_cast<long long>(graph.instrs.size());
+            }
+        }});
+
+        manager.add(Pass{"liveness", Kind::ANALYSIS, {"cfg"}, [](Context &context) {
+            context.liveness.clear();
+            for (const auto &graph : context.graphs) {
+                context.liveness.emplace_back(graph);
+                context.counters["liveness.visits"] += context.liveness.back().solution.visits;
+            }
+        }});
+
+        manager.add(Pass{"ssa", Kind::ANALYSIS, {"cfg"}, [](Context &context) {
+            ssa::ReturnTypes returnTypes;
+            for (const auto &func : context.program->funcs) {
+                returnTypes[func->id->value] = func->return_type->type;
+            }
+            for (const auto &function : context.imports) {
+                returnTypes[function.name] = function.returnType;
+            }
+            context.functions.clear();
+            for (const auto &graph : context.graphs) {
+                context.functions.push_back(ssa::build(graph, returnTypes));
+                context.counters["ssa.instrs"] += context.functions.back().numLiveInstrs();
+            }
+        }});
+
+        manager.add(Pass{"warnings", Kind::TRANSFORM, {"cfg"}, [](Context &context) {
+            for (const auto &graph : context.graphs) {
+                dataflow::reportWarnings(graph, dataflow::DefiniteAssignment(graph));
+            }
+        }});
+
+        manager.add(Pass{"pack-frames", Kind::TRANSFORM, {"liveness"}, [](Context &context) {
+            for (size_t i = 0; i < context.graphs.size(); ++i) {
+                frame::FrameLayout layout = frame::layoutFrame(context.graphs[i], context.liveness[i]);
+                frame::recordOffsets(context.graphs[i], layout, context.packedOffsets);
+                frame::report(std::cerr, layout);
+                context.counters["pack-frames.saved"] += layout.scopedSize - layout.packedSize;
+            }
+            context.scopes.usePackedOffsets(&context.packedOffsets);
+        }});
+
+        manager.add(Pass{"semantic", Kind::TRANSFORM, {"bodies"}, [](Context &context) {
+            perf::Phase phase(perf::SEMANTIC);
+            output::SemanticVisitor visitor;
+            visitor.importFunctions(&context.imports);
+            if (context.indexPositions) {
+                visitor.indexPositions(context.positions);
+            }
+            context.program->accept(visitor);
+            context.scopes = std::move(visitor.scopes());
+            if (context.indexPositions) {
+                context.counters["index.nodes"] += static_cast<long long>(context.positions.size());
+            }
+        }});
+
+        manager.add(ssaPass("constprop", optimizer::propagateConstants));
+        manager.add(ssaPass("unreachable", optimizer::removeUnreachableBlocks));
+        manager.add(ssaPass("copyprop", optimizer::propagateCopies));
+        manager.add(ssaPass("gvn", optimizer::numberValues));
+        manager.add(ssaPass("dce", optimizer::eliminateDeadCode));
+    }
+
+    std::vector<std::string> pipeline(int level) {
+        switch (level) {
+            case 0:
+                return {"semantic"};
+            case 1:
+                return {"semantic", "constprop", "unreachable", "copyprop", "dce"};
+            default:
+                return {"semantic", "constprop", "unreachable", "copyprop", "gvn", "copyprop", "dce"};
+        }
+    }
+
+    void printStats(std::ostream &os, const Context &context) {
+        os << "===- Statistics -===" << std::endl;
+        for (const auto &counter : context.counters) {
+            os << std::setw(12) << counter.second << "  " << counter.first << std::endl;
+        }
+    }
+}
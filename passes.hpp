@@ -0,0 +1,106 @@
+#ifndef PASSES_HPP
+#define PASSES_HPP
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+#include "nodes.hpp"
+#include "cfg.hpp"
+#include "dataflow.hpp"
+#include "frame.hpp"
+#include "interfaces.hpp"
+#include "output.hpp"
+#include "posindex.hpp"
+#include "ssa.hpp"
+
+namespace passes {
+
+    /* State shared by all passes: the AST and every analysis or IR built from it */
+    struct Context {
+        std::shared_ptr<ast::Funcs> program;
+        // Functions of other units, declared by the interfaces given with --import
+        std::vector<interfaces::Function> imports;
+        std::vector<cfg::FunctionCFG> graphs;
+        std::vector<dataflow::Liveness> liveness;
+        std::vector<ssa::Function> functions;
+        frame::PackedOffsets packedOffsets;
+        // Scopes of the checked program, printed once the pipeline ran
+        output::ScopePrinter scopes;
+        // Position index of the checked program, filled by the semantic pass when indexPositions is set (--query)
+        posindex::Index positions;
+        bool indexPositions = false;
+        // Statistics counters, printed by --stats
+        std::map<std::string, long long> counters;
+    };
+
+    /* Analyses compute information and can be recomputed on demand; transforms change the program or IR */
+    enum class Kind {
+        ANALYSIS,
+        TRANSFORM
+    };
+
+    /* A registered pass */
+    struct Pass {
+        std::string name;
+        Kind kind;
+        // Analyses that must be valid before the pass runs
+        std::vector<std::string> dependencies;
+        std::function<void(Context &)> run;
+    };
+
+    /* Time and allocations spent in one run of a pass */
+    struct Timing {
+        std::string pass;
+        long long micros;
+        long long allocations;
+        long long bytes;
+    };
+
+    /* Runs passes in order, computing required analyses first and tracking which ones are still valid */
+    class PassManager {
+    private:
+        std::vector<Pass> registry;
+        std::map<std::string, size_t> byName;
+        std::set<std::string> valid;
+        std::vector<Timing> timings;
+
+        // Drops the analysis and, transitively, every analysis requiring it
+        void invalidate(const std::string &name);
+
+    public:
+        // Registers a pass. Names must be unique
+        void add(Pass pass);
+
+        // True if a pass with the given name is registered
+        bool has(const std::string &name) const;
+
+        // Makes the analysis valid, running it (and its requirements) if needed
+        void require(const std::string &name, Context &context);
+
+        // Runs the pass unconditionally, after its requirements
+        void run(const std::string &name, Context &context);
+
+        // Runs the passes in order
+        void runPipeline(const std::vector<std::string> &pipeline, Context &context);
+
+        // Prints per-pass wall time and allocations, and their totals
+        void printTimings(std::ostream &os) const;
+    };
+
+    // Registers the passes of the compiler: bodies (parses the function bodies a lazy parse skipped), signatures
+    // (checks and prints the global scope only), cfg, liveness, ssa, pack-frames, warnings, semantic and the SSA
+    // optimizations
+    void registerStandardPasses(PassManager &manager);
+
+    // Passes run at the given optimization level (0-2)
+    std::vector<std::string> pipeline(int level);
+
+    // Prints the statistics counters
+    void printStats(std::ostream &os, const Context &context);
+}
+
+#endif //PASSES_HPP
@@ -0,0 +1,148 @@
+#include "perfcounters.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace perf {
+
+    bool enabled = false;
+
+    /* Counter and phase state */
+
+    enum Event {
+        CYCLES,
+        INSTRUCTIONS,
+        CACHE_MISSES,
+        BRANCH_MISSES,
+        NUM_EVENTS
+    };
+
+    static const char *eventNames[NUM_EVENTS] = {"cycles", "instructions", "cache-misses", "branch-misses"};
+
+    static const char *phaseNames[NUM_PHASES] = {"lex", "parse", "semantic", "print"};
+
+    // File descriptor of every event, -1 if it could not be opened. The first open one leads the group
+    static int fds[NUM_EVENTS] = {-1, -1, -1, -1};
+    static int leader = -1;
+    static uint64_t totals[NUM_PHASES][NUM_EVENTS] = {};
+    static uint64_t last[NUM_EVENTS] = {};
+    static std::vector<PhaseId> stack;
+
+    /* Helper functions */
+
+#ifdef __linux__
+    // Counts the calling thread only. attr.inherit stays unset, as it cannot be combined with group
+    // reads, so the work of the --lex-threads scanner threads is not counted in the lex phase
+    static int openEvent(uint64_t config, int group) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = group < 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+#endif
+
+    // Reads all open counters at once
+    static void readCounters(uint64_t values[NUM_EVENTS]) {
+#ifdef __linux__
+        uint64_t buffer[1 + NUM_EVENTS] = {};
+        if (read(leader, buffer, sizeof(buffer)) < 0) {
+            return;
+        }
+        uint64_t index = 1;
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            values[e] = fds[e] >= 0 && index <= buffer[0] ? buffer[index++] : 0;
+        }
+#endif
+    }
+
+    // Charges the counts since the last reading to the phase on top of the stack
+    static void charge() {
+        uint64_t now[NUM_EVENTS] = {};
+        readCounters(now);
+        if (!stack.empty()) {
+            for (int e = 0; e < NUM_EVENTS; ++e) {
+                totals[stack.back()][e] += now[e] - last[e];
+            }
+        }
+        std::memcpy(last, now, sizeof(last));
+    }
+
+    /* Counting */
+
+    void start() {
+#ifdef __linux__
+        static const uint64_t configs[NUM_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                     PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            fds[e] = openEvent(configs[e], leader);
+            if (fds[e] >= 0 && leader < 0) {
+                leader = fds[e];
+            }
+        }
+        if (leader < 0) {
+            std::cerr << "note: hardware performance counters are unavailable (" << std::strerror(errno) << ")"
+                      << std::endl;
+            return;
+        }
+        ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        enabled = true;
+#else
+        std::cerr << "note: hardware performance counters are only supported on Linux" << std::endl;
+#endif
+    }
+
+    void begin(PhaseId phase) {
+        charge();
+        stack.push_back(phase);
+    }
+
+    void end() {
+        charge();
+        stack.pop_back();
+    }
+
+    void report(std::ostream &os) {
+        if (!enabled) {
+            return;
+        }
+        os << "===- Performance counters -===" << std::endl;
+        os << std::setw(10) << "phase";
+        for (int e = 0; e < NUM_EVENTS; ++e) {
+            os << std::setw(16) << eventNames[e];
+        }
+        os << std::setw(8) << "IPC" << std::endl;
+
+        for (int p = 0; p < NUM_PHASES; ++p) {
+            os << std::setw(10) << phaseNames[p];
+            for (int e = 0; e < NUM_EVENTS; ++e) {
+                if (fds[e] >= 0) {
+                    os << std::setw(16) << totals[p][e];
+                } else {
+                    os << std::setw(16) << "n/a";
+                }
+            }
+            if (fds[CYCLES] >= 0 && fds[INSTRUCTIONS] >= 0 && totals[p][CYCLES] > 0) {
+                os << std::setw(8) << std::fixed << std::setprecision(2)
+                   << static_cast<double>(totals[p][INSTRUCTIONS]) / totals[p][CYCLES];
+            }
+            os << std::endl;
+        }
+    }
+}
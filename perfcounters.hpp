@@ -0,0 +1,55 @@
+#ifndef PERFCOUNTERS_HPP
+#define PERFCOUNTERS_HPP
+
+#include <ostream>
+
+/* Hardware performance counters (cycles, instructions, cache and branch misses) per compiler phase,
+ * read through perf_event_open on Linux. Each phase is charged exclusively: time spent in a nested
+ * phase (e.g. lexing inside parsing) is not counted in the enclosing one.
+ */
+namespace perf {
+
+    /* Phases the counters are attributed to */
+    enum PhaseId {
+        LEX,
+        PARSE,
+        SEMANTIC,
+        PRINT,
+        NUM_PHASES
+    };
+
+    // True once start() succeeded in opening at least one counter
+    extern bool enabled;
+
+    // Opens the counters. Prints a note and leaves counting disabled if none is available
+    void start();
+
+    void begin(PhaseId phase);
+
+    void end();
+
+    // Prints the counters of every phase
+    void report(std::ostream &os);
+
+    /* Attributes the enclosing C++ scope to a phase */
+    class Phase {
+    public:
+        explicit Phase(PhaseId phase) {
+            if (enabled) {
+                begin(phase);
+            }
+        }
+
+        ~Phase() {
+            if (enabled) {
+                end();
+            }
+        }
+
+        Phase(const Phase &) = delete;
+
+        Phase &operator=(const Phase &) = delete;
+    };
+}
+
+#endif //PERFCOUNTERS_HPP
@@ -0,0 +1,270 @@
+#include "posindex.hpp"
+#include "types.hpp"
+#include <algorithm>
+#include <cstdio>
+
+namespace posindex {
+
+    namespace {
+        uint64_t key(int line, int column) {
+            return static_cast<uint64_t>(line) << 32 | static_cast<uint32_t>(column);
+        }
+    }
+
+    /* Builder implementation */
+
+    Builder::Builder() : index(nullptr) {}
+
+    Builder::Builder(Index &index) : index(&index), spans(locations::table().decodeAll()) {}
+
+    void Builder::startSegment(int line, int column, int entry) {
+        uint64_t start = key(line, column);
+        if (!index->segmentStarts.empty() && start <= index->segmentStarts.back()) {
+            // A node starting where the previous segment starts is inside it
+            if (start == index->segmentStarts.back()) {
+                index->segmentEntries.back() = entry;
+            }
+            return;
+        }
+        index->segmentStarts.push_back(start);
+        index->segmentEntries.push_back(entry);
+    }
+
+    int Builder::addEntry(const locations::Span &span) {
+        index->entries.push_back(Entry{span, ast::BuiltInType::VOID, false, -1});
+        return static_cast<int>(index->entries.size() - 1);
+    }
+
+    int Builder::define(Definition definition) {
+        index->definitions.push_back(std::move(definition));
+        return static_cast<int>(index->definitions.size() - 1);
+    }
+
+    void Builder::openNode(const ast::Node &node) {
+        if (!index) {
+            return;
+        }
+        const locations::Span &span = spans[node.location];
+        int entry = addEntry(span);
+        startSegment(span.firstLine, span.firstColumn, entry);
+        open.push_back(Open{entry, false, -1, -1});
+    }
+
+    void Builder::openList() {
+        if (!index) {
+            return;
+        }
+        open.push_back(Open{addEntry({}), true, -1, -1});
+    }
+
+    void Builder::close() {
+        if (!index) {
+            return;
+        }
+        Open closed = open.back();
+        open.pop_back();
+        if (closed.list) {
+            if (closed.first < 0) {
+                // Nothing was added since the list opened
+                index->entries.pop_back();
+                return;
+            }
+            const locations::Span &first = index->entries[closed.first].span;
+            const locations::Span &last = index->entries[closed.last].span;
+            index->entries[closed.entry].span = {first.firstLine, first.firstColumn, last.lastLine, last.lastColumn};
+        }
+        int parent = -1;
+        if (!open.empty()) {
+            Open &enclosing = open.back();
+            enclosing.first = enclosing.first < 0 ? closed.entry : enclosing.first;
+            enclosing.last = closed.entry;
+            parent = enclosing.entry;
+        }
+        // Hands the rest of the parent's span back to it
+        const locations::Span &span = index->entries[closed.entry].span;
+        startSegment(span.lastLine, span.lastColumn + 1, parent);
+    }
+
+    void Builder::close(ast::BuiltInType type) {
+        if (!index) {
+            return;
+        }
+        Entry &entry = index->entries[open.back().entry];
+        entry.type = type;
+        entry.typed = true;
+        close();
+    }
+
+    void Builder::addName(const ast::ID &id, int definition, ast::BuiltInType type) {
+        openNode(id);
+        Entry &entry = index->entries[open.back().entry];
+        entry.definition = definition;
+        references.emplace_back(definition, entry.span);
+        close(type);
+    }
+
+    void Builder::typeName(const ast::Type &type) {
+        if (!index) {
+            return;
+        }
+        openNode(type);
+        close(type.type);
+    }
+
+    void Builder::variable(const ast::ID &id, const Symbol &symbol) {
+        if (!index) {
+            return;
+        }
+        addName(id, symbol.definition, symbol.type);
+    }
+
+    int Builder::declareVariable(const ast::ID &id, ast::BuiltInType type) {
+        if (!index) {
+            return -1;
+        }
+        int definition = define(Definition{id.value, type, false, {}, spans[id.location], true});
+        addName(id, definition, type);
+        return definition;
+    }
+
+    void Builder::function(const ast::ID &id, const FunctionSymbolTable &table, bool declaration) {
+        if (!index) {
+            return;
+        }
+        const FunctionSymbolTable::FunctionEntry *function = table.lookupFunction(id.value);
+        if (!function) {
+            return;
+        }
+        auto it = functions.find(function);
+        if (it == functions.end()) {
+            // Builtin and imported functions are never declared, so they keep no span
+            Definition definition{function->name, function->returnType, true, {}, {}, false};
+            for (int i = 0; i < function->params.size; i++) {
+                definition.params.push_back(function->params[i]);
+            }
+            it = functions.emplace(function, define(std::move(definition))).first;
+        }
+        if (declaration) {
+            index->definitions[it->second].span = spans[id.location];
+            index->definitions[it->second].hasSpan = true;
+        }
+        addName(id, it->second, function->returnType);
+    }
+
+    void Builder::finish() {
+        if (!index) {
+            return;
+        }
+        index->referenceStarts.assign(index->definitions.size() + 1, 0);
+        for (const auto &reference : references) {
+            index->referenceStarts[reference.first + 1]++;
+        }
+        for (size_t i = 1; i < index->referenceStarts.size(); i++) {
+            index->referenceStarts[i] += index->referenceStarts[i - 1];
+        }
+        std::vector<int> next(index->referenceStarts.begin(), index->referenceStarts.end() - 1);
+        index->references.resize(references.size());
+        for (const auto &reference : references) {
+            index->references[next[reference.first]++] = reference.second;
+        }
+    }
+
+    /* Index implementation */
+
+    const Entry *Index::at(int line, int column) const {
+        auto it = std::upper_bound(segmentStarts.begin(), segmentStarts.end(), key(line, column));
+        if (it == segmentStarts.begin()) {
+            return nullptr;
+        }
+        int entry = segmentEntries[it - segmentStarts.begin() - 1];
+        return entry < 0 ? nullptr : &entries[entry];
+    }
+
+    bool Index::typeAt(int line, int column, ast::BuiltInType &type) const {
+        const Entry *entry = at(line, column);
+        if (!entry || !entry->typed) {
+            return false;
+        }
+        type = entry->type;
+        return true;
+    }
+
+    int Index::definitionAt(int line, int column) const {
+        const Entry *entry = at(line, column);
+        return entry ? entry->definition : -1;
+    }
+
+    const Definition &Index::definition(int index) const {
+        return definitions[index];
+    }
+
+    const locations::Span *Index::referencesBegin(int definition) const {
+        return references.data() + referenceStarts[definition];
+    }
+
+    const locations::Span *Index::referencesEnd(int definition) const {
+        return references.data() + referenceStarts[definition + 1];
+    }
+
+    size_t Index::size() const {
+        return entries.size();
+    }
+
+    namespace {
+        void printSpan(std::ostream &os, const locations::Span &span) {
+            os << span.firstLine << ":" << span.firstColumn << "-" << span.lastLine << ":" << span.lastColumn;
+        }
+    }
+
+    bool query(const Index &index, const std::string &request, std::ostream &os) {
+        char kind[16];
+        int line;
+        int column;
+        char end;
+        if (std::sscanf(request.c_str(), "%15[a-z]:%d:%d%c", kind, &line, &column, &end) != 3) {
+            return false;
+        }
+        std::string name = kind;
+        if (name == "type") {
+            ast::BuiltInType type;
+            os << "type " << line << ":" << column << ": "
+               << (index.typeAt(line, column, type) ? types::name(type) : "none") << std::endl;
+            return true;
+        }
+        if (name != "definition" && name != "references") {
+            return false;
+        }
+        os << name << " " << line << ":" << column << ":";
+        int definition = index.definitionAt(line, column);
+        if (definition < 0) {
+            os << " none" << std::endl;
+            return true;
+        }
+        if (name == "references") {
+            for (const locations::Span *it = index.referencesBegin(definition); it != index.referencesEnd(definition);
+                 ++it) {
+                os << " ";
+                printSpan(os, *it);
+            }
+            os << std::endl;
+            return true;
+        }
+        // Printed as in the scope printer: "x int" or "f (int,byte) -> int", then the declaring span
+        const Definition &found = index.definition(definition);
+        os << " " << found.name << " ";
+        if (found.isFunction) {
+            os << "(";
+            for (size_t i = 0; i < found.params.size(); i++) {
+                os << (i ? "," : "") << types::name(found.params[i]);
+            }
+            os << ") -> ";
+        }
+        os << types::name(found.type);
+        if (found.hasSpan) {
+            os << " ";
+            printSpan(os, found.span);
+        }
+        os << std::endl;
+        return true;
+    }
+}
@@ -0,0 +1,145 @@
+#ifndef POSINDEX_HPP
+#define POSINDEX_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "locations.hpp"
+#include "nodes.hpp"
+#include "symbols.hpp"
+
+/* Index from source positions to the nodes of a checked program, answering editor queries (the type at a
+ * position, the definition of a name, all references to it) without walking the tree again. The index
+ * keeps no pointers into the AST, so it can outlive it */
+namespace posindex {
+
+    /* A node of the program */
+    struct Entry {
+        locations::Span span;
+        // Type of an expression or type name; statements and declarations have none
+        ast::BuiltInType type;
+        bool typed;
+        // Definition an identifier refers to or declares, or -1
+        int definition;
+    };
+
+    /* A function, parameter or local variable */
+    struct Definition {
+        std::string name;
+        // Type of the variable, return type of the function
+        ast::BuiltInType type;
+        bool isFunction;
+        // Parameter types of a function
+        std::vector<ast::BuiltInType> params;
+        // Span of the declaring identifier; builtin and imported functions have none
+        locations::Span span;
+        bool hasSpan;
+    };
+
+    /* The index. Node spans nest, so the source splits into segments that each lie in the same innermost
+     * node; a position is looked up by binary search over the sorted segment starts */
+    class Index {
+    private:
+        std::vector<Entry> entries;
+        std::vector<Definition> definitions;
+        // Start of every segment as (line << 32 | column), sorted, and the innermost entry over it or -1
+        std::vector<uint64_t> segmentStarts;
+        std::vector<int> segmentEntries;
+        // References of definition d are references[referenceStarts[d], referenceStarts[d + 1]), in source order
+        std::vector<int> referenceStarts;
+        std::vector<locations::Span> references;
+
+        friend class Builder;
+
+    public:
+        // Innermost node containing the position, or nullptr
+        const Entry *at(int line, int column) const;
+
+        // Type of the innermost node containing the position; false if that node has no type
+        bool typeAt(int line, int column, ast::BuiltInType &type) const;
+
+        // Definition the identifier at the position refers to or declares, or -1
+        int definitionAt(int line, int column) const;
+
+        const Definition &definition(int index) const;
+
+        // Spans of all identifiers referring to the definition, its declaration included
+        const locations::Span *referencesBegin(int definition) const;
+
+        const locations::Span *referencesEnd(int definition) const;
+
+        // Number of indexed nodes
+        size_t size() const;
+    };
+
+    /* Fills an index from the semantic visitor, which reports the nodes as it checks them. Nodes are opened in
+     * source order and closed innermost first. A builder made without an index ignores every call, so the visitor
+     * reports unconditionally */
+    class Builder {
+    private:
+        /* An open node, and for a list, its first and last items */
+        struct Open {
+            int entry;
+            bool list;
+            int first;
+            int last;
+        };
+
+        Index *index;
+        // Spans of all nodes, decoded once
+        std::vector<locations::Span> spans;
+        std::vector<Open> open;
+        // Definition of every function referred to so far
+        std::unordered_map<const FunctionSymbolTable::FunctionEntry *, int> functions;
+        // (definition, span) of every identifier with a definition, in source order
+        std::vector<std::pair<int, locations::Span>> references;
+
+        void startSegment(int line, int column, int entry);
+
+        int addEntry(const locations::Span &span);
+
+        int define(Definition definition);
+
+        // Adds an identifier, which refers to or declares the definition
+        void addName(const ast::ID &id, int definition, ast::BuiltInType type);
+
+    public:
+        Builder();
+
+        explicit Builder(Index &index);
+
+        void openNode(const ast::Node &node);
+
+        // The parser gives a list the span of one of its items, so a list spans from its first item to its last
+        // one instead. An empty list has no entry
+        void openList();
+
+        void close();
+
+        // Closes an expression, which has the given type
+        void close(ast::BuiltInType type);
+
+        // Adds a type name
+        void typeName(const ast::Type &type);
+
+        // Adds a reference to a variable
+        void variable(const ast::ID &id, const Symbol &symbol);
+
+        // Adds the declaration of a variable and returns its definition, or -1 if positions are not indexed
+        int declareVariable(const ast::ID &id, ast::BuiltInType type);
+
+        // Adds the name of a function in a call or in its declaration. An unknown name is skipped, as the call fails
+        void function(const ast::ID &id, const FunctionSymbolTable &table, bool declaration);
+
+        // Groups the references by definition; the index is complete afterwards
+        void finish();
+    };
+
+    // Answers a query "type:<line>:<column>", "definition:<line>:<column>" or "references:<line>:<column>" on
+    // one line. Returns false if the query is malformed
+    bool query(const Index &index, const std::string &request, std::ostream &os);
+}
+
+#endif //POSINDEX_HPP
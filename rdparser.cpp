@@ -0,0 +1,395 @@
+#include "rdparser.hpp"
+#include "output.hpp"
+#include "tokens.hpp"
+#include "parser.tab.h"
+#include <vector>
+
+namespace rdparser {
+
+    namespace {
+        // Binding power of a binary operator token, following the %left declarations of parser.y from
+        // loosest to tightest, or 0 if the token is not a binary operator
+        int bindingPower(int kind) {
+            switch (kind) {
+                case OR:
+                    return 1;
+                case AND:
+                    return 2;
+                case NE:
+                    return 3;
+                case EQ:
+                    return 4;
+                case LT:
+                case LE:
+                case GT:
+                case GE:
+                    return 5;
+                case ADD:
+                case SUB:
+                    return 6;
+                case MUL:
+                case DIV:
+                    return 7;
+                default:
+                    return 0;
+            }
+        }
+
+        std::shared_ptr<ast::Exp> makeBinary(int kind, std::shared_ptr<ast::Exp> left, std::shared_ptr<ast::Exp> right) {
+            switch (kind) {
+                case OR:
+                    return std::make_shared<ast::Or>(left, right);
+                case AND:
+                    return std::make_shared<ast::And>(left, right);
+                case NE:
+                    return std::make_shared<ast::RelOp>(left, right, ast::RelOpType::NE);
+                case EQ:
+                    return std::make_shared<ast::RelOp>(left, right, ast::RelOpType::EQ);
+                case LT:
+                    return std::make_shared<ast::RelOp>(left, right, ast::RelOpType::LT);
+                case LE:
+                    return std::make_shared<ast::RelOp>(left, right, ast::RelOpType::LE);
+                case GT:
+                    return std::make_shared<ast::RelOp>(left, right, ast::RelOpType::GT);
+                case GE:
+                    return std::make_shared<ast::RelOp>(left, right, ast::RelOpType::GE);
+                case ADD:
+                    return std::make_shared<ast::BinOp>(left, right, ast::BinOpType::ADD);
+                case SUB:
+                    return std::make_shared<ast::BinOp>(left, right, ast::BinOpType::SUB);
+                case MUL:
+                    return std::make_shared<ast::BinOp>(left, right, ast::BinOpType::MUL);
+                default:
+                    return std::make_shared<ast::BinOp>(left, right, ast::BinOpType::DIV);
+            }
+        }
+
+        bool isType(int kind) {
+            return kind == INT || kind == BYTE || kind == BOOL;
+        }
+
+        /* A parsed grammar symbol: its node and the location bison would give the symbol */
+        template<typename T>
+        struct Parsed {
+            std::shared_ptr<T> node;
+            YYLTYPE location;
+        };
+
+        /* Parser state: a single token of lookahead, read only when a decision needs it, so tokens are
+         * read (and their lexical errors reported) exactly when bison would read them */
+        class Parser {
+        private:
+            bool lazyBodies;
+            int kind = 0;
+            bool hasLookahead = false;
+            // Location of the lookahead; at the end of input it keeps the last token's, as yylloc does.
+            // Before the first token it has yylloc's initial value (%initial-action in parser.y)
+            YYLTYPE location = {1, 1, 1, 1, 0, -1};
+
+            int peek() {
+                if (!hasLookahead) {
+                    kind = tokens::next(location);
+                    hasLookahead = true;
+                }
+                return kind;
+            }
+
+            YYLTYPE consume() {
+                peek();
+                hasLookahead = false;
+                return location;
+            }
+
+            // Reports a syntax error at the lookahead; does not return
+            void fail() {
+                output::errorSyn(location.first_line);
+            }
+
+            YYLTYPE expect(int expected) {
+                if (peek() != expected) {
+                    fail();
+                }
+                return consume();
+            }
+
+            static std::shared_ptr<ast::ID> leafID(const YYLTYPE &id) {
+                return std::static_pointer_cast<ast::ID>(tokens::leaf(id));
+            }
+
+        public:
+            explicit Parser(bool lazyBodies) : lazyBodies(lazyBodies) {}
+
+            std::shared_ptr<ast::Funcs> program() {
+                // Funcs is left recursive: its list is created by the empty rule, before the first token is read
+                tokens::reduceEmpty(location);
+                auto result = std::make_shared<ast::Funcs>();
+                while (peek() != 0) {
+                    result->push_back(funcDecl().node);
+                }
+                return result;
+            }
+
+            Parsed<ast::FuncDecl> funcDecl() {
+                Parsed<ast::Type> returnType = peek() == VOID ? voidType() : type();
+                YYLTYPE id = expect(ID);
+                YYLTYPE lparen = expect(LPAREN);
+                std::shared_ptr<ast::Formals> params = formals(lparen);
+                expect(RPAREN);
+                YYLTYPE lbrace = expect(LBRACE);
+                std::shared_ptr<ast::Statements> body;
+                if (lazyBodies) {
+                    tokens::skipBlock(location);
+                } else {
+                    body = statements();
+                }
+                YYLTYPE rbrace = expect(RBRACE);
+                YYLTYPE span = tokens::reduce(returnType.location, rbrace);
+                auto func = std::make_shared<ast::FuncDecl>(leafID(id), returnType.node, params, body);
+                if (lazyBodies) {
+                    func->firstBodyToken = lbrace.last_token + 1;
+                    func->lastBodyToken = rbrace.first_token - 1;
+                }
+                return {func, span};
+            }
+
+            Parsed<ast::Type> voidType() {
+                YYLTYPE token = consume();
+                YYLTYPE span = tokens::reduce(token, token);
+                return {std::make_shared<ast::Type>(ast::BuiltInType::VOID), span};
+            }
+
+            Parsed<ast::Type> type() {
+                int token = peek();
+                if (!isType(token)) {
+                    fail();
+                }
+                YYLTYPE span = tokens::reduce(location, location);
+                consume();
+                ast::BuiltInType builtIn = token == INT ? ast::BuiltInType::INT
+                                                        : token == BYTE ? ast::BuiltInType::BYTE
+                                                                        : ast::BuiltInType::BOOL;
+                return {std::make_shared<ast::Type>(builtIn), span};
+            }
+
+            std::shared_ptr<ast::Formals> formals(const YYLTYPE &lparen) {
+                if (peek() == RPAREN) {
+                    tokens::reduceEmpty(lparen);
+                    return std::make_shared<ast::Formals>();
+                }
+                Parsed<ast::Formal> first = formal();
+                // Left recursive like Funcs: the list is created as soon as the first declaration is reduced
+                tokens::reduce(first.location, first.location);
+                auto result = std::make_shared<ast::Formals>();
+                result->push_back(first.node);
+                while (peek() == COMMA) {
+                    consume();
+                    result->push_back(formal().node);
+                }
+                return result;
+            }
+
+            Parsed<ast::Formal> formal() {
+                Parsed<ast::Type> paramType = type();
+                YYLTYPE id = expect(ID);
+                YYLTYPE span = tokens::reduce(paramType.location, id);
+                return {std::make_shared<ast::Formal>(leafID(id), paramType.node), span};
+            }
+
+            // One or more statements, up to the closing brace
+            std::shared_ptr<ast::Statements> statements() {
+                Parsed<ast::Statement> first = statement();
+                // Left recursive: the list is created as soon as the first statement is reduced
+                tokens::reduce(first.location, first.location);
+                auto result = std::make_shared<ast::Statements>();
+                result->push_back(first.node);
+                while (peek() != RBRACE) {
+                    result->push_back(statement().node);
+                }
+                return result;
+            }
+
+            Parsed<ast::Statement> statement() {
+                switch (peek()) {
+                    case LBRACE: {
+                        YYLTYPE lbrace = consume();
+                        std::shared_ptr<ast::Statements> body = statements();
+                        YYLTYPE rbrace = expect(RBRACE);
+                        return {body, tokens::reduce(lbrace, rbrace)};
+                    }
+                    case INT:
+                    case BYTE:
+                    case BOOL: {
+                        Parsed<ast::Type> varType = type();
+                        YYLTYPE id = expect(ID);
+                        std::shared_ptr<ast::Exp> init;
+                        if (peek() != SC) {
+                            expect(ASSIGN);
+                            init = exp().node;
+                        }
+                        YYLTYPE span = tokens::reduce(varType.location, expect(SC));
+                        return {std::make_shared<ast::VarDecl>(leafID(id), varType.node, init), span};
+                    }
+                    case ID: {
+                        YYLTYPE id = consume();
+                        if (peek() == LPAREN) {
+                            Parsed<ast::Call> invocation = call(id);
+                            return {invocation.node, tokens::reduce(invocation.location, expect(SC))};
+                        }
+                        expect(ASSIGN);
+                        std::shared_ptr<ast::Exp> value = exp().node;
+                        YYLTYPE span = tokens::reduce(id, expect(SC));
+                        return {std::make_shared<ast::Assign>(leafID(id), value), span};
+                    }
+                    case RETURN: {
+                        YYLTYPE keyword = consume();
+                        std::shared_ptr<ast::Exp> value;
+                        if (peek() != SC) {
+                            value = exp().node;
+                        }
+                        YYLTYPE span = tokens::reduce(keyword, expect(SC));
+                        return {std::make_shared<ast::Return>(value), span};
+                    }
+                    case IF: {
+                        YYLTYPE keyword = consume();
+                        expect(LPAREN);
+                        std::shared_ptr<ast::Exp> condition = exp().node;
+                        expect(RPAREN);
+                        Parsed<ast::Statement> then = statement();
+                        // The dangling else binds to the nearest if (LOWER_THAN_ELSE in parser.y)
+                        if (peek() != ELSE) {
+                            YYLTYPE span = tokens::reduce(keyword, then.location);
+                            return {std::make_shared<ast::If>(condition, then.node), span};
+                        }
+                        consume();
+                        Parsed<ast::Statement> otherwise = statement();
+                        YYLTYPE span = tokens::reduce(keyword, otherwise.location);
+                        return {std::make_shared<ast::If>(condition, then.node, otherwise.node), span};
+                    }
+                    case WHILE: {
+                        YYLTYPE keyword = consume();
+                        expect(LPAREN);
+                        std::shared_ptr<ast::Exp> condition = exp().node;
+                        expect(RPAREN);
+                        Parsed<ast::Statement> body = statement();
+                        YYLTYPE span = tokens::reduce(keyword, body.location);
+                        return {std::make_shared<ast::While>(condition, body.node), span};
+                    }
+                    case BREAK: {
+                        YYLTYPE keyword = consume();
+                        YYLTYPE span = tokens::reduce(keyword, expect(SC));
+                        return {std::make_shared<ast::Break>(), span};
+                    }
+                    case CONTINUE: {
+                        YYLTYPE keyword = consume();
+                        YYLTYPE span = tokens::reduce(keyword, expect(SC));
+                        return {std::make_shared<ast::Continue>(), span};
+                    }
+                    default:
+                        fail();
+                        return {};
+                }
+            }
+
+            // The rest of a call, after its identifier
+            Parsed<ast::Call> call(const YYLTYPE &id) {
+                consume();
+                if (peek() == RPAREN) {
+                    YYLTYPE span = tokens::reduce(id, consume());
+                    return {std::make_shared<ast::Call>(leafID(id)), span};
+                }
+                Parsed<ast::Exp> first = exp();
+                // Left recursive: the list is created as soon as the first argument is reduced
+                tokens::reduce(first.location, first.location);
+                auto list = std::make_shared<ast::ExpList>(first.node);
+                while (peek() == COMMA) {
+                    consume();
+                    list->push_back(exp().node);
+                }
+                YYLTYPE span = tokens::reduce(id, expect(RPAREN));
+                return {std::make_shared<ast::Call>(leafID(id), list), span};
+            }
+
+            // An expression whose binary operators all bind at least as tightly as minPower. Operators are
+            // left associative, so the right operand only takes operators binding more tightly
+            Parsed<ast::Exp> exp(int minPower = 1) {
+                Parsed<ast::Exp> left = unary();
+                int power;
+                while ((power = bindingPower(peek())) >= minPower) {
+                    int op = kind;
+                    consume();
+                    Parsed<ast::Exp> right = exp(power + 1);
+                    YYLTYPE span = tokens::reduce(left.location, right.location);
+                    left = {makeBinary(op, left.node, right.node), span};
+                }
+                return left;
+            }
+
+            // A primary expression or a prefix operator. Casts and not bind more tightly than every binary
+            // operator (CAST and NOT in parser.y), so their operand is again a unary expression
+            Parsed<ast::Exp> unary() {
+                switch (peek()) {
+                    case LPAREN: {
+                        YYLTYPE lparen = consume();
+                        if (isType(peek())) {
+                            Parsed<ast::Type> target = type();
+                            expect(RPAREN);
+                            Parsed<ast::Exp> operand = unary();
+                            YYLTYPE span = tokens::reduce(lparen, operand.location);
+                            return {std::make_shared<ast::Cast>(operand.node, target.node), span};
+                        }
+                        // Parentheses make no node, but the enclosing rule spans them
+                        std::shared_ptr<ast::Exp> inner = exp().node;
+                        return {inner, tokens::reduce(lparen, expect(RPAREN))};
+                    }
+                    case NOT: {
+                        YYLTYPE keyword = consume();
+                        Parsed<ast::Exp> operand = unary();
+                        YYLTYPE span = tokens::reduce(keyword, operand.location);
+                        return {std::make_shared<ast::Not>(operand.node), span};
+                    }
+                    case ID: {
+                        YYLTYPE id = consume();
+                        if (peek() == LPAREN) {
+                            Parsed<ast::Call> invocation = call(id);
+                            return {invocation.node, invocation.location};
+                        }
+                        return {leafID(id), tokens::reduce(id, id)};
+                    }
+                    case NUM:
+                    case NUM_B:
+                    case STRING: {
+                        YYLTYPE literal = consume();
+                        YYLTYPE span = tokens::reduce(literal, literal);
+                        return {tokens::leaf(literal), span};
+                    }
+                    case TRUE:
+                    case FALSE: {
+                        bool value = kind == TRUE;
+                        YYLTYPE literal = consume();
+                        YYLTYPE span = tokens::reduce(literal, literal);
+                        return {std::make_shared<ast::Bool>(value), span};
+                    }
+                    default:
+                        fail();
+                        return {};
+                }
+            }
+        };
+    }
+
+    std::shared_ptr<ast::Funcs> parse(bool lazyBodies) {
+        Parser parser(lazyBodies);
+        return parser.program();
+    }
+
+    void parseBody(ast::FuncDecl &func) {
+        if (func.body) {
+            return;
+        }
+        // The body ends at its closing brace, which the statements leave unread
+        tokens::seek(func.firstBodyToken);
+        Parser parser(false);
+        func.body = parser.statements();
+        func.firstBodyToken = func.lastBodyToken = -1;
+    }
+}
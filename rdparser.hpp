@@ -0,0 +1,22 @@
+#ifndef RDPARSER_HPP
+#define RDPARSER_HPP
+
+#include <memory>
+#include "nodes.hpp"
+
+/* Hand-written parser accepting the grammar of parser.y: recursive descent for declarations and
+ * statements, and precedence climbing (Pratt) for expressions. It reads the same token stream, builds the
+ * same nodes with the same spans in the same order, and reports a syntax error at the same token as the
+ * bison parser, since both stop at the first token that cannot continue a valid program */
+namespace rdparser {
+
+    // Parses the tokens of tokens::buffer() into the program. With lazyBodies, only the function headers are
+    // parsed: each body is skipped by matching braces and left for parseBody, so its syntax and lexical
+    // errors are reported only when it is parsed
+    std::shared_ptr<ast::Funcs> parse(bool lazyBodies = false);
+
+    // Parses the body of a function skipped by a lazy parse; does nothing if the body is already parsed
+    void parseBody(ast::FuncDecl &func);
+}
+
+#endif //RDPARSER_HPP
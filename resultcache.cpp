@@ -0,0 +1,272 @@
+#include "resultcache.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <streambuf>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace resultcache {
+
+    namespace {
+        // Build stamp of the compiler. Every build gets new keys, so entries of other builds never match
+        const char *const VERSION = "hw3 " __DATE__ " " __TIME__;
+
+        const char *const ENTRY_SUFFIX = ".out";
+
+        // writeAtomically's temporary files end in this suffix and a random number
+        const char *const TEMPORARY_SUFFIX = ".tmp";
+
+        // Temporary files older than this belong to runs that died before renaming them
+        const auto STALE_TEMPORARY_AGE = std::chrono::minutes(10);
+
+        uint64_t hashBytes(uint64_t hash, std::string_view bytes) {
+            for (char c : bytes) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        // The entry of a key is named by the hex FNV-1a hash of the key
+        std::string entryPath(const std::string &directory, const std::string &key) {
+            char hex[17];
+            std::snprintf(hex, sizeof(hex), "%016llx",
+                          static_cast<unsigned long long>(hashBytes(14695981039346656037ull, key)));
+            return directory + "/" + hex + ENTRY_SUFFIX;
+        }
+
+        /* Counters kept in the cache directory across runs, as "name value" lines. Concurrent runs may lose
+         * an update */
+        struct Stats {
+            long long hits = 0;
+            long long misses = 0;
+            long long evictions = 0;
+        };
+
+        std::string statsPath(const std::string &directory) {
+            return directory + "/stats";
+        }
+
+        Stats readStats(const std::string &directory) {
+            Stats counters;
+            std::ifstream in(statsPath(directory));
+            std::string name;
+            long long value;
+            while (in >> name >> value) {
+                if (name == "hits") {
+                    counters.hits = value;
+                } else if (name == "misses") {
+                    counters.misses = value;
+                } else if (name == "evictions") {
+                    counters.evictions = value;
+                }
+            }
+            return counters;
+        }
+
+        void writeStats(const std::string &directory, const Stats &stats) {
+            writeAtomically(statsPath(directory), "hits " + std::to_string(stats.hits) + "\nmisses " +
+                                                  std::to_string(stats.misses) + "\nevictions " +
+                                                  std::to_string(stats.evictions) + "\n");
+        }
+
+        bool isStaleTemporary(const fs::directory_entry &file, fs::file_time_type now) {
+            std::string name = file.path().filename().string();
+            if (name.find(TEMPORARY_SUFFIX) == std::string::npos) {
+                return false;
+            }
+            std::error_code error;
+            fs::file_time_type modified = fs::last_write_time(file.path(), error);
+            return !error && now - modified > STALE_TEMPORARY_AGE;
+        }
+
+        // Removes stale temporary files, then the least recently used entries until the entries take at most
+        // maxBytes, and returns how many entries were removed
+        long long evict(const std::string &directory, long long maxBytes) {
+            struct Entry {
+                fs::path path;
+                fs::file_time_type used;
+                long long size;
+            };
+            std::vector<Entry> entries;
+            long long total = 0;
+            std::error_code error;
+            fs::file_time_type now = fs::file_time_type::clock::now();
+            for (const auto &file : fs::directory_iterator(directory, error)) {
+                if (isStaleTemporary(file, now)) {
+                    fs::remove(file.path(), error);
+                    continue;
+                }
+                if (file.path().extension() != ENTRY_SUFFIX) {
+                    continue;
+                }
+                Entry entry{file.path(), fs::last_write_time(file.path(), error),
+                            static_cast<long long>(fs::file_size(file.path(), error))};
+                if (error) {
+                    // Removed by a concurrent run
+                    continue;
+                }
+                total += entry.size;
+                entries.push_back(entry);
+            }
+            std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+                return a.used < b.used;
+            });
+            long long evicted = 0;
+            for (const Entry &entry : entries) {
+                if (total <= maxBytes) {
+                    break;
+                }
+                if (fs::remove(entry.path, error)) {
+                    evicted++;
+                }
+                total -= entry.size;
+            }
+            return evicted;
+        }
+
+        /* Stream buffer passing everything through to another one and keeping a copy */
+        class TeeBuffer : public std::streambuf {
+        private:
+            std::streambuf *target;
+
+        public:
+            std::string captured;
+
+            explicit TeeBuffer(std::streambuf *target) : target(target) {}
+
+            std::streambuf *original() const {
+                return target;
+            }
+
+        protected:
+            int overflow(int c) override {
+                if (c == traits_type::eof()) {
+                    return traits_type::not_eof(c);
+                }
+                captured.push_back(static_cast<char>(c));
+                return target->sputc(static_cast<char>(c));
+            }
+
+            std::streamsize xsputn(const char *s, std::streamsize n) override {
+                captured.append(s, static_cast<size_t>(n));
+                return target->sputn(s, n);
+            }
+
+            int sync() override {
+                return target->pubsync();
+            }
+        };
+
+        /* The capture in progress, stored by the exit handler */
+        struct Capture {
+            std::string directory;
+            std::string key;
+            long long maxBytes = 0;
+            std::unique_ptr<TeeBuffer> buffer;
+        };
+
+        Capture &activeCapture() {
+            static Capture capture;
+            return capture;
+        }
+
+        void storeCapture() {
+            Capture &capture = activeCapture();
+            std::cout.flush();
+            std::cout.rdbuf(capture.buffer->original());
+            // The entry is the length of the key on a line, the key, then the output
+            std::string entry = std::to_string(capture.key.size()) + "\n" + capture.key + capture.buffer->captured;
+            if (static_cast<long long>(entry.size()) > capture.maxBytes ||
+                !writeAtomically(entryPath(capture.directory, capture.key), entry)) {
+                return;
+            }
+            long long evicted = evict(capture.directory, capture.maxBytes);
+            if (evicted > 0) {
+                Stats counters = readStats(capture.directory);
+                counters.evictions += evicted;
+                writeStats(capture.directory, counters);
+            }
+        }
+    }
+
+    std::string key(std::string_view source, std::string_view options) {
+        std::string key;
+        key.reserve(std::char_traits<char>::length(VERSION) + options.size() + source.size() + 3);
+        // Each part is followed by a zero byte, so moving bytes between parts changes the key
+        for (std::string_view part : {std::string_view(VERSION), options, source}) {
+            key.append(part).push_back('\0');
+        }
+        return key;
+    }
+
+    bool lookup(const std::string &directory, const std::string &key, std::string &output) {
+        std::error_code error;
+        fs::create_directories(directory, error);
+        std::string path = entryPath(directory, key);
+        std::ifstream in(path, std::ios::binary);
+        bool hit = false;
+        size_t length;
+        if (in >> length && in.get() == '\n') {
+            // Another key with the same hash is a miss; storing this run's output then replaces that entry
+            std::string stored(length, '\0');
+            if (in.read(&stored[0], static_cast<std::streamsize>(length)) && stored == key) {
+                output.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+                hit = !in.bad();
+            }
+        }
+        if (hit) {
+            // The modification time is the last use, the eviction order
+            fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+        }
+        Stats counters = readStats(directory);
+        (hit ? counters.hits : counters.misses)++;
+        writeStats(directory, counters);
+        return hit;
+    }
+
+    void capture(const std::string &directory, const std::string &key, long long maxBytes) {
+        Capture &capture = activeCapture();
+        if (capture.buffer) {
+            return;
+        }
+        capture.directory = directory;
+        capture.key = key;
+        capture.maxBytes = maxBytes;
+        capture.buffer = std::make_unique<TeeBuffer>(std::cout.rdbuf());
+        std::cout.rdbuf(capture.buffer.get());
+        // Registered after the capture was constructed, so it runs before the capture is destroyed
+        std::atexit(storeCapture);
+    }
+
+    bool writeAtomically(const std::string &path, std::string_view bytes) {
+        std::string temporary = path + ".tmp" + std::to_string(std::random_device()());
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if (!out.flush()) {
+                out.close();
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+        std::error_code error;
+        fs::rename(temporary, path, error);
+        if (error) {
+            std::remove(temporary.c_str());
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef RESULTCACHE_HPP
+#define RESULTCACHE_HPP
+
+#include <string>
+#include <string_view>
+
+/* On-disk cache of whole compilation results. An entry holds everything a run wrote to std::cout (the scope
+ * printer output or the diagnostic line), keyed by the compiler build, the options and the source, so a
+ * repeated compilation replays it without scanning the input. An entry is named by a hash of its key and
+ * stores the key itself, which a lookup compares, so two keys sharing a hash never replay each other's output.
+ * Entries are evicted least recently used first once the directory grows past its size bound */
+namespace resultcache {
+
+    // Key of a compilation: the compiler build, the options and the source, each followed by a zero byte
+    std::string key(std::string_view source, std::string_view options);
+
+    // Reads the output stored under the key into `output`; a hit marks the entry as recently used. Either way
+    // the hit or miss is counted in <directory>/stats
+    bool lookup(const std::string &directory, const std::string &key, std::string &output);
+
+    // Records everything written to std::cout from now on and stores it under the key at exit, including exits
+    // by a compile error, then evicts the least recently used entries until the directory holds at most maxBytes.
+    // Temporary files left behind by runs that died while writing are swept at the same time
+    void capture(const std::string &directory, const std::string &key, long long maxBytes);
+
+    // Writes the file through a temporary file in the same directory renamed over it, so readers see either
+    // the old or the new content and never a partial one
+    bool writeAtomically(const std::string &path, std::string_view bytes);
+}
+
+#endif //RESULTCACHE_HPP
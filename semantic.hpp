@@ -0,0 +1,116 @@
+#ifndef SEMANTIC_HPP
+#define SEMANTIC_HPP
+
+#include <string>
+#include <vector>
+#include "visitor.hpp"
+#include "nodes.hpp"
+#include "output.hpp"
+#include "posindex.hpp"
+#include "symbols.hpp"
+
+namespace interfaces {
+    struct Function;
+}
+
+namespace output {
+
+    /* Enters print, printi, the imported functions and the functions of the program into funcTab, in that
+     * order, reporting conflicts and redefinitions, and emits their signatures to the printer. Freezes funcTab */
+    void populateFunctionTable(FunctionSymbolTable &funcTab, ScopePrinter &printer,
+                               const std::vector<interfaces::Function> *imports, const ast::Funcs &program);
+
+    /* Semantic analysis of the program. Checks scopes and types, reporting the first error, and collects the
+     * global scope with the frame offset of every variable, to be printed once the whole program checked */
+    class SemanticVisitor : public Visitor {
+    private:
+        ScopePrinter printer;
+        SymbolTable symTab;
+        FunctionSymbolTable funcTab;
+        // Functions of other units, entered into funcTab before the functions of the program
+        const std::vector<interfaces::Function> *imports;
+        // Reports the checked nodes to the position index, if one was requested
+        posindex::Builder positions;
+        // Type of the expression visited last
+        ast::BuiltInType expType;
+        // Return type of the function being checked
+        ast::BuiltInType returnType;
+        // Number of loops around the statement being checked
+        int loopDepth;
+
+        /* Visits the expression and returns its type */
+        ast::BuiltInType typeOf(ast::Exp &exp);
+
+        /* Visits a statement in its own scope, as If and While bodies are scoped */
+        void visitScoped(ast::Statement &statement);
+
+        /* Reports an error if the name is already taken by a visible variable or a function */
+        void checkUnused(int lineno, const std::string &name);
+
+    public:
+        SemanticVisitor();
+
+        /* The scopes of the program, complete once it checked */
+        ScopePrinter &scopes();
+
+        /* Makes the functions of other units callable (see interfaces.hpp) */
+        void importFunctions(const std::vector<interfaces::Function> *functions);
+
+        /* Fills the index with the positions of the program while checking it (see posindex.hpp) */
+        void indexPositions(posindex::Index &index);
+
+        void visit(ast::Num &node) override;
+
+        void visit(ast::NumB &node) override;
+
+        void visit(ast::String &node) override;
+
+        void visit(ast::Bool &node) override;
+
+        void visit(ast::ID &node) override;
+
+        void visit(ast::BinOp &node) override;
+
+        void visit(ast::RelOp &node) override;
+
+        void visit(ast::Not &node) override;
+
+        void visit(ast::And &node) override;
+
+        void visit(ast::Or &node) override;
+
+        void visit(ast::Type &node) override;
+
+        void visit(ast::Cast &node) override;
+
+        void visit(ast::ExpList &node) override;
+
+        void visit(ast::Call &node) override;
+
+        void visit(ast::Statements &node) override;
+
+        void visit(ast::Break &node) override;
+
+        void visit(ast::Continue &node) override;
+
+        void visit(ast::Return &node) override;
+
+        void visit(ast::If &node) override;
+
+        void visit(ast::While &node) override;
+
+        void visit(ast::VarDecl &node) override;
+
+        void visit(ast::Assign &node) override;
+
+        void visit(ast::Formal &node) override;
+
+        void visit(ast::Formals &node) override;
+
+        void visit(ast::FuncDecl &node) override;
+
+        void visit(ast::Funcs &node) override;
+    };
+}
+
+#endif //SEMANTIC_HPP
@@ -0,0 +1,286 @@
+#include "simdlexer.hpp"
+#include "memstats.hpp"
+#include "parser.tab.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace simdlexer {
+
+    /* Character classes */
+
+    static bool isDigit(char c) {
+        return c >= '0' && c <= '9';
+    }
+
+    static bool isAlpha(char c) {
+        return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+    }
+
+    /* Block scanning. Each function returns the position of the first character not in its class;
+     * the source is padded with NULs, which are in none of them, so whole blocks can be read */
+
+#ifdef __SSE2__
+    // Mask of the bytes of the block that are in [low, high]. Bytes above 0x7f compare as negative and never match
+    static __m128i inRange(__m128i block, char low, char high) {
+        return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(low - 1))),
+                             _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(high + 1))));
+    }
+
+    static __m128i equals(__m128i block, char c) {
+        return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+    }
+
+    // Advances over whole blocks whose bytes all satisfy `inClass`, returning the first byte that does not
+    template<typename Class>
+    static const char *skipBlocks(const char *p, Class inClass) {
+        for (;;) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(inClass(block))) ^ 0xffffu;
+            if (mask) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+    }
+
+    static const char *skipSpaces(const char *p) {
+        return skipBlocks(p, [](__m128i block) {
+            return _mm_or_si128(_mm_or_si128(equals(block, ' '), equals(block, '\t')),
+                                _mm_or_si128(equals(block, '\n'), equals(block, '\r')));
+        });
+    }
+
+    static const char *skipDigits(const char *p) {
+        return skipBlocks(p, [](__m128i block) {
+            return inRange(block, '0', '9');
+        });
+    }
+
+    static const char *skipAlnums(const char *p) {
+        return skipBlocks(p, [](__m128i block) {
+            __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+            return _mm_or_si128(inRange(lower, 'a', 'z'), inRange(block, '0', '9'));
+        });
+    }
+
+    static const char *skipLine(const char *p, const char *end) {
+        // The padding holds no newline, so the search is bounded by the end of the source
+        for (; p < end; p += 16) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(equals(block, '\n'),
+                                                                                 equals(block, '\r'))));
+            if (mask) {
+                return std::min(p + __builtin_ctz(mask), end);
+            }
+        }
+        return end;
+    }
+
+    static const char *skipStringBody(const char *p) {
+        return skipBlocks(p, [](__m128i block) {
+            __m128i special = _mm_or_si128(_mm_or_si128(equals(block, '"'), equals(block, '\\')),
+                                           _mm_or_si128(equals(block, '\n'), equals(block, '\r')));
+            // NUL stops the scan too, so that the padding is noticed
+            __m128i nul = equals(block, '\0');
+            return _mm_andnot_si128(_mm_or_si128(special, nul), _mm_set1_epi8(-1));
+        });
+    }
+#else
+    static bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    static bool isAlnum(char c) {
+        return isAlpha(c) || isDigit(c);
+    }
+
+    // Characters that end the body of a string literal or need a closer look
+    static bool isStringSpecial(char c) {
+        return c == '"' || c == '\\' || c == '\n' || c == '\r';
+    }
+
+    static const char *skipSpaces(const char *p) {
+        while (isSpace(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    static const char *skipDigits(const char *p) {
+        while (isDigit(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    static const char *skipAlnums(const char *p) {
+        while (isAlnum(*p)) {
+            p++;
+        }
+        return p;
+    }
+
+    static const char *skipLine(const char *p, const char *end) {
+        while (p < end && *p != '\n' && *p != '\r') {
+            p++;
+        }
+        return p;
+    }
+
+    static const char *skipStringBody(const char *p) {
+        while (*p && !isStringSpecial(*p)) {
+            p++;
+        }
+        return p;
+    }
+#endif
+
+    /* Tokens */
+
+    // Kind of a keyword, or ID
+    static int keyword(const char *p, size_t length) {
+        static const struct {
+            const char *text;
+            int kind;
+        } keywords[] = {
+                {"void", VOID}, {"int", INT}, {"byte", BYTE}, {"bool", BOOL}, {"and", AND}, {"or", OR},
+                {"not", NOT}, {"true", TRUE}, {"false", FALSE}, {"return", RETURN}, {"if", IF},
+                {"else", ELSE}, {"while", WHILE}, {"break", BREAK}, {"continue", CONTINUE}
+        };
+        if (length < 2 || length > 8) {
+            return ID;
+        }
+        for (const auto &word : keywords) {
+            if (word.text[0] == p[0] && std::strlen(word.text) == length && std::memcmp(word.text, p, length) == 0) {
+                return word.kind;
+            }
+        }
+        return ID;
+    }
+
+    // End of the string literal starting at the quote, or nullptr if the quote starts none
+    static const char *stringEnd(const char *quote, const char *end) {
+        const char *p = quote + 1;
+        for (;;) {
+            p = skipStringBody(p);
+            if (p >= end) {
+                return nullptr;
+            }
+            if (*p == '\0') {
+                // A NUL inside the source is an ordinary character of the literal
+                p++;
+                continue;
+            }
+            if (*p == '"') {
+                // The literal needs at least one character
+                return p > quote + 1 ? p + 1 : nullptr;
+            }
+            if (*p != '\\') {
+                // A newline or carriage return
+                return nullptr;
+            }
+            char escaped = p[1];
+            if (escaped != 'r' && escaped != 'n' && escaped != 't' && escaped != '"' && escaped != '\\') {
+                return nullptr;
+            }
+            p += 2;
+        }
+    }
+
+    void scanSource(tokens::TokenBuffer &buffer) {
+        memstats::TagScope tag(memstats::LEXER);
+        const char *begin = buffer.source.data();
+        const char *end = begin + buffer.length();
+        const char *p = begin;
+        buffer.tokens.reserve(buffer.length() / 5);
+
+        auto push = [&](int kind, const char *start, const char *stop, int payload) {
+            buffer.push(kind, static_cast<uint32_t>(start - begin), static_cast<uint32_t>(stop - start), payload);
+        };
+
+        for (;;) {
+            p = skipSpaces(p);
+            if (p >= end) {
+                break;
+            }
+            const char *start = p;
+            char c = *p;
+
+            if (isAlpha(c)) {
+                p = skipAlnums(p + 1);
+                int kind = keyword(start, p - start);
+                push(kind, start, p, kind == ID ? buffer.internName(std::string_view(start, p - start)) : 0);
+            } else if (isDigit(c)) {
+                // 0|[1-9][0-9]* and 0b|[1-9][0-9]*b
+                p = c == '0' ? p + 1 : skipDigits(p + 1);
+                bool isByte = *p == 'b' && p < end;
+                int value = 0;
+                bool fits = std::from_chars(start, p, value).ec == std::errc();
+                if (isByte) {
+                    p++;
+                }
+                if (fits) {
+                    push(isByte ? NUM_B : NUM, start, p, value);
+                } else {
+                    push(tokens::ERROR, start, p, tokens::NUM_TOO_LARGE);
+                }
+            } else if (c == '"') {
+                const char *stop = stringEnd(start, end);
+                if (stop) {
+                    p = stop;
+                    // Interned by tokens::scan, like the literals of the flex scanner
+                    push(STRING, start, p, 0);
+                } else {
+                    p++;
+                    push(tokens::ERROR, start, p, tokens::LEXICAL);
+                }
+            } else if (c == '/' && p[1] == '/' && p + 1 < end) {
+                // The line break itself is left to the whitespace rule
+                p = skipLine(p + 2, end);
+            } else {
+                int kind = tokens::ERROR;
+                size_t length = 1;
+                char next = p + 1 < end ? p[1] : '\0';
+                switch (c) {
+                    case ';': kind = SC; break;
+                    case ',': kind = COMMA; break;
+                    case '(': kind = LPAREN; break;
+                    case ')': kind = RPAREN; break;
+                    case '{': kind = LBRACE; break;
+                    case '}': kind = RBRACE; break;
+                    case '+': kind = ADD; break;
+                    case '-': kind = SUB; break;
+                    case '*': kind = MUL; break;
+                    case '/': kind = DIV; break;
+                    case '=':
+                        kind = next == '=' ? EQ : ASSIGN;
+                        length = next == '=' ? 2 : 1;
+                        break;
+                    case '<':
+                        kind = next == '=' ? LE : LT;
+                        length = next == '=' ? 2 : 1;
+                        break;
+                    case '>':
+                        kind = next == '=' ? GE : GT;
+                        length = next == '=' ? 2 : 1;
+                        break;
+                    case '!':
+                        if (next == '=') {
+                            kind = NE;
+                            length = 2;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+                p += length;
+                push(kind, start, p, kind == tokens::ERROR ? tokens::LEXICAL : 0);
+            }
+        }
+        buffer.indexLines();
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef SIMDLEXER_HPP
+#define SIMDLEXER_HPP
+
+#include "tokens.hpp"
+
+/* Hand-written scanner producing exactly the tokens of scanner.lex. Whitespace, comments and the
+ * ends of identifiers, numbers and strings are found 16 bytes at a time with SSE2 where available */
+namespace simdlexer {
+
+    // Scans the buffer's source, with the same contract as tokens::scanSource
+    void scanSource(tokens::TokenBuffer &buffer);
+}
+
+#endif //SIMDLEXER_HPP
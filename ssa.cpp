@@ -0,0 +1,483 @@
+#include "ssa.hpp"
+#include "types.hpp"
+#include <algorithm>
+
+namespace ssa {
+
+    /* Helper functions */
+
+    static const char *opName(const Instr &instr) {
+        static const char *binOps[] = {"add", "sub", "mul", "div"};
+        static const char *relOps[] = {"eq", "ne", "lt", "gt", "le", "ge"};
+        switch (instr.op) {
+            case Op::CONST:
+                return "const";
+            case Op::STRING:
+                return "string";
+            case Op::PARAM:
+                return "param";
+            case Op::PHI:
+                return "phi";
+            case Op::BINOP:
+                return binOps[instr.sub];
+            case Op::RELOP:
+                return relOps[instr.sub];
+            case Op::NOT:
+                return "not";
+            case Op::CAST:
+                return "cast";
+            case Op::CALL:
+                return "call";
+            case Op::RETURN:
+                return "ret";
+            case Op::BRANCH:
+                return "br";
+            default:
+                return "unknown";
+        }
+    }
+
+    /* Function implementation */
+
+    int Function::resolve(int v) const {
+        while (forward[v] >= 0) {
+            v = forward[v];
+        }
+        return v;
+    }
+
+    void Function::replace(int from, int to) {
+        forward[from] = to;
+        instrs[from].dead = true;
+    }
+
+    void Function::canonicalize() {
+        for (Instr &instr : instrs) {
+            if (instr.dead) {
+                continue;
+            }
+            for (int &arg : instr.args) {
+                arg = resolve(arg);
+            }
+        }
+    }
+
+    int Function::numLiveInstrs() const {
+        int result = 0;
+        for (const Instr &instr : instrs) {
+            result += !instr.dead;
+        }
+        return result;
+    }
+
+    bool Function::hasSideEffects(const Instr &instr) const {
+        switch (instr.op) {
+            case Op::CALL:
+            case Op::RETURN:
+            case Op::BRANCH:
+                return true;
+            case Op::BINOP: {
+                // Division traps on zero unless the divisor is a known non-zero constant
+                if (instr.sub != ast::BinOpType::DIV) {
+                    return false;
+                }
+                const Instr &divisor = instrs[resolve(instr.args[1])];
+                return divisor.op != Op::CONST || divisor.value == 0;
+            }
+            default:
+                return false;
+        }
+    }
+
+    void Function::dump(std::ostream &os) const {
+        os << "function " << name << std::endl;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            const Block &block = blocks[b];
+            if (block.dead) {
+                continue;
+            }
+            os << "bb" << b << ":";
+            if (!block.preds.empty()) {
+                os << " ; preds";
+                for (int pred : block.preds) {
+                    os << " bb" << pred;
+                }
+            }
+            os << std::endl;
+
+            for (const auto *list : {&block.phis, &block.instrs}) {
+                for (int v : *list) {
+                    const Instr &instr = instrs[v];
+                    if (instr.dead) {
+                        continue;
+                    }
+                    os << "  ";
+                    if (instr.type != ast::BuiltInType::VOID) {
+                        os << "%" << v << " = ";
+                    }
+                    os << opName(instr);
+                    if (instr.op == Op::CAST || instr.type != ast::BuiltInType::VOID) {
+                        os << " " << types::name(instr.type);
+                    }
+                    if (instr.op == Op::CONST || instr.op == Op::PARAM) {
+                        os << " " << instr.value;
+                    } else if (instr.op == Op::STRING) {
+                        os << " \"" << dynamic_cast<ast::String *>(instr.origin)->value() << "\"";
+                    } else if (instr.op == Op::CALL) {
+                        os << " " << dynamic_cast<ast::Call *>(instr.origin)->func_id->value;
+                    }
+                    for (size_t i = 0; i < instr.args.size(); ++i) {
+                        os << (i == 0 ? " " : ", ") << "%" << resolve(instr.args[i]);
+                    }
+                    os << std::endl;
+                }
+            }
+
+            if (!block.succs.empty()) {
+                os << "  ->";
+                for (int succ : block.succs) {
+                    os << " bb" << succ;
+                }
+                os << std::endl;
+            }
+        }
+    }
+
+    /* SSA construction */
+
+    /* Lowers expressions to instructions of the current block and tracks the current
+     * definition of every local per block. Phis are created when a variable is read in a
+     * block without a local definition, and completed once all predecessors are filled.
+     * Short-circuit operators split the current block, so the right operand only runs when
+     * the left one does not decide the result.
+     */
+    class Builder : public Visitor {
+    private:
+        const cfg::FunctionCFG &graph;
+        const ReturnTypes &returnTypes;
+        Function &func;
+        int current;
+        // Value of the last visited expression
+        int result;
+        // Per block: slot -> current value
+        std::vector<std::unordered_map<int, int>> defs;
+        std::vector<bool> filled;
+        std::vector<bool> sealed;
+        // Per block: (slot, phi) pairs waiting for the block to be sealed
+        std::vector<std::vector<std::pair<int, int>>> incomplete;
+        // Per block split off by a short-circuit operator: the block it was split from, whose
+        // definitions it shares since expressions assign no locals; -1 for blocks of the CFG
+        std::vector<int> splitFrom;
+
+        int emit(Op op, int sub, ast::BuiltInType type, int value, std::vector<int> args, ast::Node *origin) {
+            func.instrs.push_back(Instr{op, sub, type, value, std::move(args), current, false, origin});
+            func.forward.push_back(-1);
+            int v = static_cast<int>(func.instrs.size()) - 1;
+            func.blocks[current].instrs.push_back(v);
+            return v;
+        }
+
+        int newPhi(int block, int slot) {
+            func.instrs.push_back(Instr{Op::PHI, 0, graph.locals[slot].type, slot, {}, block, false, nullptr});
+            func.forward.push_back(-1);
+            int v = static_cast<int>(func.instrs.size()) - 1;
+            func.blocks[block].phis.push_back(v);
+            return v;
+        }
+
+        // Default value of a local read before any write (FanC zero-initializes)
+        int zero(int block, ast::BuiltInType type) {
+            func.instrs.push_back(Instr{Op::CONST, 0, type, 0, {}, block, false, nullptr});
+            func.forward.push_back(-1);
+            int v = static_cast<int>(func.instrs.size()) - 1;
+            auto &list = func.blocks[block].instrs;
+            list.insert(list.begin(), v);
+            return v;
+        }
+
+        void write(int slot, int block, int value) {
+            defs[block][slot] = value;
+        }
+
+        int read(int slot, int block) {
+            auto it = defs[block].find(slot);
+            if (it != defs[block].end()) {
+                return it->second;
+            }
+
+            int value;
+            const auto &preds = func.blocks[block].preds;
+            if (splitFrom[block] >= 0) {
+                value = read(slot, splitFrom[block]);
+            } else if (!sealed[block]) {
+                value = newPhi(block, slot);
+                incomplete[block].emplace_back(slot, value);
+            } else if (preds.empty()) {
+                value = zero(block, graph.locals[slot].type);
+            } else if (preds.size() == 1) {
+                value = read(slot, preds[0]);
+            } else {
+                value = newPhi(block, slot);
+                write(slot, block, value);
+                addPhiOperands(slot, value);
+            }
+            write(slot, block, value);
+            return value;
+        }
+
+        void addPhiOperands(int slot, int phi) {
+            std::vector<int> args;
+            for (int pred : func.blocks[func.instrs[phi].block].preds) {
+                args.push_back(read(slot, pred));
+            }
+            func.instrs[phi].args = std::move(args);
+        }
+
+        void seal(int block) {
+            for (const auto &pending : incomplete[block]) {
+                addPhiOperands(pending.first, pending.second);
+            }
+            incomplete[block].clear();
+            sealed[block] = true;
+        }
+
+        // Seals the block once all of its predecessors are filled
+        void trySeal(int block) {
+            if (sealed[block]) {
+                return;
+            }
+            for (int pred : func.blocks[block].preds) {
+                if (!filled[pred]) {
+                    return;
+                }
+            }
+            seal(block);
+        }
+
+        int lower(ast::Exp &exp) {
+            exp.accept(*this);
+            return result;
+        }
+
+        // Appends a block split off the given one, already sealed
+        int newBlock(int from) {
+            func.blocks.push_back(Block{{}, {}, {}, {}, false});
+            defs.emplace_back();
+            filled.push_back(false);
+            sealed.push_back(true);
+            incomplete.emplace_back();
+            splitFrom.push_back(from);
+            return static_cast<int>(func.blocks.size()) - 1;
+        }
+
+        // Lowers `left and right` or `left or right`: the current block branches on the left operand
+        // to a block computing the right one, or straight to a join block whose phi selects the result.
+        // The join block takes over the rest of the current block and its successors
+        void lowerShortCircuit(ast::Exp &node, ast::Exp &left, ast::Exp &right, bool isOr) {
+            int leftValue = lower(left);
+            int from = current;
+            int rightBlock = newBlock(from);
+            int join = newBlock(from);
+
+            func.blocks[join].succs = std::move(func.blocks[from].succs);
+            for (int succ : func.blocks[join].succs) {
+                std::replace(func.blocks[succ].preds.begin(), func.blocks[succ].preds.end(), from, join);
+            }
+            emit(Op::BRANCH, 0, ast::BuiltInType::VOID, 0, {leftValue}, &node);
+            func.blocks[from].succs = isOr ? std::vector<int>{join, rightBlock} : std::vector<int>{rightBlock, join};
+            func.blocks[rightBlock].preds = {from};
+            filled[from] = true;
+
+            current = rightBlock;
+            int rightValue = lower(right);
+            int rightEnd = current;
+            func.blocks[rightEnd].succs = {join};
+            filled[rightEnd] = true;
+
+            // Straight from the split block, the result is the left operand itself
+            func.blocks[join].preds = {from, rightEnd};
+            current = join;
+            func.instrs.push_back(Instr{Op::PHI, 0, ast::BuiltInType::BOOL, -1, {leftValue, rightValue}, join, false,
+                                        &node});
+            func.forward.push_back(-1);
+            result = static_cast<int>(func.instrs.size()) - 1;
+            func.blocks[join].phis.push_back(result);
+        }
+
+        void lowerInstr(const cfg::Instr &instr) {
+            switch (instr.kind) {
+                case cfg::InstrKind::VarDecl: {
+                    auto decl = dynamic_cast<ast::VarDecl *>(instr.node);
+                    int value = decl->init_exp ? lower(*decl->init_exp)
+                                               : emit(Op::CONST, 0, decl->type->type, 0, {}, decl);
+                    write(instr.def, current, value);
+                    break;
+                }
+                case cfg::InstrKind::Assign: {
+                    int value = lower(*dynamic_cast<ast::Assign *>(instr.node)->exp);
+                    if (instr.def >= 0) {
+                        write(instr.def, current, value);
+                    }
+                    break;
+                }
+                case cfg::InstrKind::Call:
+                    lower(*dynamic_cast<ast::Call *>(instr.node));
+                    break;
+                case cfg::InstrKind::Return: {
+                    auto ret = dynamic_cast<ast::Return *>(instr.node);
+                    std::vector<int> args;
+                    if (ret->exp) {
+                        args.push_back(lower(*ret->exp));
+                    }
+                    emit(Op::RETURN, 0, ast::BuiltInType::VOID, 0, std::move(args), ret);
+                    break;
+                }
+                case cfg::InstrKind::Branch: {
+                    auto cond = dynamic_cast<ast::Exp *>(instr.node);
+                    emit(Op::BRANCH, 0, ast::BuiltInType::VOID, 0, {lower(*cond)}, cond);
+                    break;
+                }
+            }
+        }
+
+    public:
+        Builder(const cfg::FunctionCFG &graph, const ReturnTypes &returnTypes, Function &func)
+                : graph(graph), returnTypes(returnTypes), func(func), current(cfg::FunctionCFG::ENTRY), result(-1),
+                  defs(graph.numBlocks()), filled(graph.numBlocks(), false), sealed(graph.numBlocks(), false),
+                  incomplete(graph.numBlocks()), splitFrom(graph.numBlocks(), -1) {}
+
+        void run() {
+            int numBlocks = graph.numBlocks();
+            func.name = graph.name;
+            func.blocks.assign(numBlocks, Block{{}, {}, {}, {}, true});
+            for (int b : graph.rpo) {
+                Block &block = func.blocks[b];
+                block.dead = false;
+                block.succs.assign(graph.succsBegin(b), graph.succsEnd(b));
+                for (const int *pred = graph.predsBegin(b); pred != graph.predsEnd(b); ++pred) {
+                    if (graph.blocks[*pred].reachable) {
+                        block.preds.push_back(*pred);
+                    }
+                }
+            }
+
+            // Parameters are defined on entry
+            current = cfg::FunctionCFG::ENTRY;
+            int param = 0;
+            for (int slot = 0; slot < graph.numLocals(); ++slot) {
+                if (graph.locals[slot].isParam) {
+                    write(slot, current, emit(Op::PARAM, 0, graph.locals[slot].type, param++, {},
+                                              graph.locals[slot].decl));
+                }
+            }
+
+            for (int b : graph.rpo) {
+                current = b;
+                trySeal(b);
+                for (const cfg::Instr *instr = graph.instrsBegin(b); instr != graph.instrsEnd(b); ++instr) {
+                    lowerInstr(*instr);
+                }
+                // A short-circuit operator may have moved the end of the block to a split-off one
+                filled[current] = true;
+                for (int succ : func.blocks[current].succs) {
+                    trySeal(succ);
+                }
+            }
+        }
+
+        void visit(ast::Num &node) override {
+            result = emit(Op::CONST, 0, ast::BuiltInType::INT, node.value, {}, &node);
+        }
+
+        void visit(ast::NumB &node) override {
+            result = emit(Op::CONST, 0, ast::BuiltInType::BYTE, node.value, {}, &node);
+        }
+
+        void visit(ast::String &node) override {
+            result = emit(Op::STRING, 0, ast::BuiltInType::STRING, 0, {}, &node);
+        }
+
+        void visit(ast::Bool &node) override {
+            result = emit(Op::CONST, 0, ast::BuiltInType::BOOL, node.value, {}, &node);
+        }
+
+        void visit(ast::ID &node) override {
+            auto it = graph.slotOfId.find(&node);
+            result = it != graph.slotOfId.end() ? read(it->second, current)
+                                                 : emit(Op::CONST, 0, ast::BuiltInType::INT, 0, {}, &node);
+        }
+
+        void visit(ast::BinOp &node) override {
+            int left = lower(*node.left);
+            int right = lower(*node.right);
+            result = emit(Op::BINOP, node.op, types::binOpResult(func.instrs[left].type, func.instrs[right].type), 0,
+                          {left, right}, &node);
+        }
+
+        void visit(ast::RelOp &node) override {
+            int left = lower(*node.left);
+            int right = lower(*node.right);
+            result = emit(Op::RELOP, node.op, ast::BuiltInType::BOOL, 0, {left, right}, &node);
+        }
+
+        void visit(ast::Not &node) override {
+            result = emit(Op::NOT, 0, ast::BuiltInType::BOOL, 0, {lower(*node.exp)}, &node);
+        }
+
+        void visit(ast::And &node) override {
+            lowerShortCircuit(node, *node.left, *node.right, false);
+        }
+
+        void visit(ast::Or &node) override {
+            lowerShortCircuit(node, *node.left, *node.right, true);
+        }
+
+        void visit(ast::Type &) override {}
+
+        void visit(ast::Cast &node) override {
+            result = emit(Op::CAST, 0, node.target_type->type, 0, {lower(*node.exp)}, &node);
+        }
+
+        void visit(ast::ExpList &) override {}
+
+        void visit(ast::Call &node) override {
+            std::vector<int> args;
+            for (const auto &arg : node.args->exps) {
+                args.push_back(lower(*arg));
+            }
+            auto it = returnTypes.find(node.func_id->value);
+            ast::BuiltInType type = it != returnTypes.end() ? it->second : ast::BuiltInType::VOID;
+            result = emit(Op::CALL, 0, type, 0, std::move(args), &node);
+        }
+
+        void visit(ast::Statements &) override {}
+
+        void visit(ast::Break &) override {}
+
+        void visit(ast::Continue &) override {}
+
+        void visit(ast::Return &) override {}
+
+        void visit(ast::If &) override {}
+
+        void visit(ast::While &) override {}
+
+        void visit(ast::VarDecl &) override {}
+
+        void visit(ast::Assign &) override {}
+
+        void visit(ast::Formal &) override {}
+
+        void visit(ast::Formals &) override {}
+
+        void visit(ast::FuncDecl &) override {}
+
+        void visit(ast::Funcs &) override {}
+    };
+
+    Function build(const cfg::FunctionCFG &graph, const ReturnTypes &returnTypes) {
+        Function func;
+        Builder(graph, returnTypes, func).run();
+        return func;
+    }
+}
@@ -0,0 +1,89 @@
+#ifndef SSA_HPP
+#define SSA_HPP
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cfg.hpp"
+
+namespace ssa {
+
+    /* SSA operations. Every instruction defines the value with its own index */
+    enum class Op {
+        CONST,   // Integer, byte or boolean constant in `value`
+        STRING,  // String literal, see `origin`
+        PARAM,   // Incoming parameter number `value`
+        PHI,     // One argument per predecessor, in predecessor order
+        BINOP,   // `sub` is an ast::BinOpType
+        RELOP,   // `sub` is an ast::RelOpType
+        NOT,
+        CAST,    // Converts the argument to `type`
+        CALL,    // `origin` is the ast::Call, arguments in order
+        RETURN,  // Zero or one argument
+        BRANCH   // Condition argument; true/false targets are the block's two successors
+    };
+
+    /* SSA instruction */
+    struct Instr {
+        Op op;
+        int sub;
+        // Type of the result (VOID for calls to void functions, returns and branches)
+        ast::BuiltInType type;
+        int value;
+        std::vector<int> args;
+        // Block the instruction lives in
+        int block;
+        // Set by passes that delete the instruction
+        bool dead;
+        // Node the instruction was lowered from, or nullptr for phis of locals and default values
+        ast::Node *origin;
+    };
+
+    /* SSA basic block. Block indices match those of the CFG the function was built from; blocks split off
+     * by short-circuit operators follow them */
+    struct Block {
+        std::vector<int> phis;
+        std::vector<int> instrs;
+        std::vector<int> preds;
+        std::vector<int> succs;
+        // Unreachable blocks are kept as empty, dead entries so indices stay stable
+        bool dead;
+    };
+
+    /* A function in SSA form */
+    class Function {
+    public:
+        std::string name;
+        std::vector<Instr> instrs;
+        std::vector<Block> blocks;
+        // Value each removed value was replaced with, or -1
+        std::vector<int> forward;
+
+        // Follows replacements to the value currently standing for v
+        int resolve(int v) const;
+
+        // Replaces every use of `from` by `to` and deletes `from`
+        void replace(int from, int to);
+
+        // Rewrites all arguments to their resolved values
+        void canonicalize();
+
+        // Number of instructions that are not dead
+        int numLiveInstrs() const;
+
+        // True for instructions that must be kept even if their value is unused
+        bool hasSideEffects(const Instr &instr) const;
+
+        // Prints the function in a human-readable format
+        void dump(std::ostream &os) const;
+    };
+
+    // Return type of every function of the program, by name
+    using ReturnTypes = std::unordered_map<std::string, ast::BuiltInType>;
+
+    // Builds SSA form from a CFG, placing phis on the fly as variables are read
+    Function build(const cfg::FunctionCFG &graph, const ReturnTypes &returnTypes);
+}
+
+#endif //SSA_HPP
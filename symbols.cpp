@@ -1,119 +1,295 @@
 #include "symbols.hpp"
+#include "output.hpp"
+#include "trace.hpp"
+#include "memstats.hpp"
+#include "types.hpp"
+#include <algorithm>
+
+using namespace std;
 
 // Symbol class implementations
-Symbol::Symbol(string name, type_t type, int offset)
-    : name(name), type(type), offset(offset) {}
+Symbol::Symbol(string_view name, ast::BuiltInType type, int offset, int definition)
+    : name(name), type(type), offset(offset), definition(definition) {}
 
 Symbol::Symbol() = default;
 
 // Scope class implementations
-Scope::Scope(int initialPositiveOffset, int initialNegativeOffset)
-    : current_negative_offset(initialNegativeOffset),
-      current_positive_offset(initialPositiveOffset),
+Scope::Scope(size_t firstSymbol, int initialPositiveOffset, int initialNegativeOffset)
+    : first_symbol(firstSymbol),
       initial_positive_offset(initialPositiveOffset),
       initial_negative_offset(initialNegativeOffset) {}
 
-int Scope::addArg(const string& name, type_t type) {
-    int offset = current_negative_offset;
-    symbols.push_back(Symbol(name, type, current_negative_offset--));
-    return offset;
+// Signature class implementations
+namespace {
+    const uint64_t LOW_BITS = 0x1111111111111111ull;
+
+    // Low bit of each nibble of x that is non-zero
+    uint64_t nonZeroNibbles(uint64_t x) {
+        return (x | (x >> 1) | (x >> 2) | (x >> 3)) & LOW_BITS;
+    }
+
+    // Low bit of each nibble of x that holds the given type
+    uint64_t nibblesOf(uint64_t x, ast::BuiltInType type) {
+        return ~nonZeroNibbles(x ^ (LOW_BITS * (type + 1))) & LOW_BITS;
+    }
+
+    // Byte to int is the only widening in the type lattice, which passableWord relies on
+    static_assert(types::assignable(ast::BuiltInType::INT, ast::BuiltInType::BYTE) &&
+                  !types::assignable(ast::BuiltInType::BYTE, ast::BuiltInType::INT), "unexpected widening");
+
+    // True if every argument nibble equals the parameter nibble or is a byte passed to an int
+    bool passableWord(uint64_t args, uint64_t params) {
+        uint64_t differing = nonZeroNibbles(args ^ params);
+        uint64_t widened = nibblesOf(args, ast::BuiltInType::BYTE) & nibblesOf(params, ast::BuiltInType::INT);
+        return (differing & ~widened) == 0;
+    }
+}
+
+Signature::Signature() : size(0), head(0) {}
+
+void Signature::push_back(ast::BuiltInType type) {
+    uint64_t nibble = static_cast<uint64_t>(type + 1) << (4 * (size % TYPES_PER_WORD));
+    if (size < TYPES_PER_WORD) {
+        head |= nibble;
+    } else {
+        if (size % TYPES_PER_WORD == 0) {
+            tail.push_back(0);
+        }
+        tail.back() |= nibble;
+    }
+    size++;
 }
 
-int Scope::addVariable(const string& name, type_t type) {
-    int offset = current_positive_offset;
-    symbols.push_back(Symbol(name, type, current_positive_offset++));
-    return offset;
+ast::BuiltInType Signature::operator[](int i) const {
+    uint64_t word = i < TYPES_PER_WORD ? head : tail[i / TYPES_PER_WORD - 1];
+    return static_cast<ast::BuiltInType>(((word >> (4 * (i % TYPES_PER_WORD))) & 0xF) - 1);
+}
+
+bool Signature::passableTo(const Signature& params) const {
+    if (size != params.size || !passableWord(head, params.head)) {
+        return false;
+    }
+    for (size_t i = 0; i < tail.size(); i++) {
+        if (!passableWord(tail[i], params.tail[i])) {
+            return false;
+        }
+    }
+    return true;
 }
 
 // FunctionSymbolTable::FunctionEntry implementations
-FunctionSymbolTable::FunctionEntry::FunctionEntry(string name, type_t returnType, shared_ptr<ast::Formals> formals)
-    : name(name), returnType(returnType), formals(formals) {}
+FunctionSymbolTable::FunctionEntry::FunctionEntry(string name, ast::BuiltInType returnType)
+    : name(name), returnType(returnType), printableBuilt(false) {}
+
+vector<string>& FunctionSymbolTable::FunctionEntry::printableParams() const {
+    if (!printableBuilt) {
+        for (int i = 0; i < params.size; i++) {
+            printable.push_back(types::name(params[i]));
+        }
+        printableBuilt = true;
+    }
+    return printable;
+}
 
 // FunctionSymbolTable class implementations
-bool FunctionSymbolTable::insertFunction(const string& name, type_t returnType, shared_ptr<ast::Formals> formals) {
-    if (functionMap.find(name) != functionMap.end()) {
+FunctionSymbolTable::FunctionSymbolTable() : frozen(false) {}
+
+uint64_t FunctionSymbolTable::hash(string_view name, uint64_t seed) {
+    // FNV-1a with a seeded basis, followed by a mixing step so the low bits depend on every byte
+    uint64_t h = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+    for (char c : name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 32;
+    h *= 0xD6E8FEB86659FD93ull;
+    h ^= h >> 32;
+    return h;
+}
+
+bool FunctionSymbolTable::insertEntry(FunctionEntry entry) {
+    memstats::TagScope tag(memstats::SYMBOLS);
+    if (frozen || !pending.emplace(entry.name, entries.size()).second) {
         return false; // Function already exists
     }
-    functionMap[name] = FunctionEntry(name, returnType, formals);
+    entries.push_back(std::move(entry));
     return true;
 }
 
+bool FunctionSymbolTable::insertFunction(const string& name, ast::BuiltInType returnType, const ast::Formals& formals) {
+    FunctionEntry entry(name, returnType);
+    for (const auto& formal : formals.formals) {
+        entry.params.push_back(formal->type->type);
+    }
+    return insertEntry(std::move(entry));
+}
+
+bool FunctionSymbolTable::insertFunction(const string& name, ast::BuiltInType returnType,
+                                         const vector<ast::BuiltInType>& params) {
+    FunctionEntry entry(name, returnType);
+    for (ast::BuiltInType type : params) {
+        entry.params.push_back(type);
+    }
+    return insertEntry(std::move(entry));
+}
+
+void FunctionSymbolTable::freeze() {
+    memstats::TagScope tag(memstats::SYMBOLS);
+    size_t n = entries.size();
+    frozen = true;
+    pending.clear();
+    if (n == 0) {
+        return;
+    }
+
+    // Hash and displace: split the names into buckets of about four, then, largest bucket first,
+    // search for a seed that sends every name of the bucket to a free slot
+    size_t numBuckets = (n + 3) / 4;
+    vector<vector<size_t>> buckets(numBuckets);
+    for (size_t i = 0; i < n; i++) {
+        buckets[hash(entries[i].name, 0) % numBuckets].push_back(i);
+    }
+    vector<size_t> order(numBuckets);
+    for (size_t b = 0; b < numBuckets; b++) {
+        order[b] = b;
+    }
+    sort(order.begin(), order.end(), [&](size_t x, size_t y) {
+        return buckets[x].size() > buckets[y].size();
+    });
+
+    // Try a minimal table first. A bucket that finds no seed within the cap would otherwise search
+    // forever, so give up on that table size and retry with a quarter more slots, which always succeeds
+    // quickly as the load factor drops
+    vector<long> owner;
+    vector<size_t> slots;
+    auto place = [&](size_t numSlots) {
+        seeds.assign(numBuckets, 0);
+        owner.assign(numSlots, -1);
+        for (size_t b : order) {
+            if (buckets[b].empty()) {
+                break;
+            }
+            uint32_t seed = 1;
+            for (; seed <= MAX_SEED_ATTEMPTS; seed++) {
+                slots.clear();
+                for (size_t i : buckets[b]) {
+                    size_t slot = hash(entries[i].name, seed) % numSlots;
+                    if (owner[slot] != -1 || find(slots.begin(), slots.end(), slot) != slots.end()) {
+                        break;
+                    }
+                    slots.push_back(slot);
+                }
+                if (slots.size() == buckets[b].size()) {
+                    break;
+                }
+            }
+            if (seed > MAX_SEED_ATTEMPTS) {
+                return false;
+            }
+            seeds[b] = seed;
+            for (size_t k = 0; k < slots.size(); k++) {
+                owner[slots[k]] = static_cast<long>(buckets[b][k]);
+            }
+        }
+        return true;
+    };
+    size_t numSlots = n;
+    while (!place(numSlots)) {
+        numSlots += numSlots / 4 + 1;
+    }
+
+    // Slots no name hashes to hold an unnamed entry, which no lookup matches
+    vector<FunctionEntry> placed;
+    placed.reserve(numSlots);
+    for (size_t slot = 0; slot < numSlots; slot++) {
+        if (owner[slot] == -1) {
+            placed.emplace_back("", ast::BuiltInType::VOID);
+        } else {
+            placed.push_back(std::move(entries[owner[slot]]));
+        }
+    }
+    entries = std::move(placed);
+}
+
 const FunctionSymbolTable::FunctionEntry* FunctionSymbolTable::lookupFunction(const string& name) const {
-    auto it = functionMap.find(name);
-    if (it != functionMap.end()) {
-        return &it->second;
+    TRACE_COUNT(SYMBOL_LOOKUPS);
+    if (!frozen) {
+        auto it = pending.find(name);
+        return it == pending.end() ? nullptr : &entries[it->second];
     }
-    return nullptr;
+    if (entries.empty()) {
+        return nullptr;
+    }
+    // One slot can hold the name; names outside the table land on some other entry and fail the comparison
+    uint32_t seed = seeds[hash(name, 0) % seeds.size()];
+    const FunctionEntry& entry = entries[hash(name, seed) % entries.size()];
+    return !entry.name.empty() && entry.name == name ? &entry : nullptr;
+}
+
+const FunctionSymbolTable::FunctionEntry* FunctionSymbolTable::validateFunctionCall(int lineno, const string& name,
+                                                                                   const Signature& args) const {
+    const FunctionEntry* function = lookupFunction(name);
+    if (!function) {
+        output::errorUndefFunc(lineno, name);
+    }
+    if (!args.passableTo(function->params)) {
+        output::errorPrototypeMismatch(lineno, name, function->printableParams());
+    }
+    return function;
 }
 
 // SymbolTable class implementations
 SymbolTable::SymbolTable() 
-    : current_positive_offset(0), current_negative_offset(-1) {}
+    : current_positive_offset(0), current_negative_offset(-1) {
+    // Sized for typical functions, so the arrays only grow for unusually deep or long ones
+    memstats::TagScope tag(memstats::SYMBOLS);
+    symbols.reserve(64);
+    scopes.reserve(16);
+}
 
 void SymbolTable::beginScope() {
-    symbols_stack.push(Scope(current_positive_offset, current_negative_offset));
+    TRACE_COUNT(SCOPES_PUSHED);
+    memstats::TagScope tag(memstats::SYMBOLS);
+    scopes.emplace_back(symbols.size(), current_positive_offset, current_negative_offset);
 }
 
 void SymbolTable::endScope() {
-    if (!symbols_stack.empty()) {
-        current_positive_offset = symbols_stack.top().current_positive_offset;
-        current_negative_offset = symbols_stack.top().current_negative_offset;
-        symbols_stack.pop();
+    if (!scopes.empty()) {
+        const Scope& scope = scopes.back();
+        symbols.resize(scope.first_symbol);
+        current_positive_offset = scope.initial_positive_offset;
+        current_negative_offset = scope.initial_negative_offset;
+        scopes.pop_back();
     }
 }
 
-int SymbolTable::addArg(const string& name, type_t type) {
-    if (!symbols_stack.empty()) {
-        int offset = symbols_stack.top().addArg(name, type);
-        current_negative_offset--;
+int SymbolTable::addArg(const ast::ID& id, ast::BuiltInType type, int definition) {
+    if (!scopes.empty()) {
+        memstats::TagScope tag(memstats::SYMBOLS);
+        int offset = current_negative_offset--;
+        symbols.emplace_back(id.value, type, offset, definition);
         return offset;
     }
     return -1; // Indicate failure
 }
 
-int SymbolTable::addVariable(const string& name, type_t type) {
-    if (!symbols_stack.empty()) {
-        int offset = symbols_stack.top().addVariable(name, type);
-        current_positive_offset++;
+int SymbolTable::addVariable(const ast::ID& id, ast::BuiltInType type, int definition) {
+    if (!scopes.empty()) {
+        memstats::TagScope tag(memstats::SYMBOLS);
+        int offset = current_positive_offset++;
+        symbols.emplace_back(id.value, type, offset, definition);
         return offset;
     }
     return -1; // Indicate failure
 }
 
 Symbol* SymbolTable::lookup(const string& name) {
-    for (auto it = symbols_stack.rbegin(); it != symbols_stack.rend(); ++it) {
-        for (const auto& symbol : it->symbols) {
-            if (symbol.name == name) {
-                return &const_cast<Symbol&>(symbol);
-            }
+    TRACE_COUNT(SYMBOL_LOOKUPS);
+    // Innermost declarations are last, so searching backwards respects shadowing
+    for (auto it = symbols.rbegin(); it != symbols.rend(); ++it) {
+        if (it->name == name) {
+            return &*it;
         }
     }
     return nullptr;
 }
-
-bool SymbolTable::validateFunctionCall(const string& name, shared_ptr<ast::FormalsList> actualParams) {
-    const auto* function = functionTable.lookupFunction(name);
-    if (!function) {
-        errorUndefFunc(0, name); // Adjust `lineno` appropriately
-        return false;
-    }
-    
-    const auto& expectedParams = function->formals;
-    if (expectedParams->size() != actualParams->size()) {
-        errorPrototypeMismatch(0, name, actualParams); // Adjust args
-        return false;
-    }
-
-    auto expectedIt = expectedParams->begin();
-    auto actualIt = actualParams->begin();
-
-    while (expectedIt != expectedParams->end() && actualIt != actualParams->end()) {
-        if ((*expectedIt)->type != (*actualIt)->type) {
-            errorMismatch(0); // Adjust `lineno` appropriately
-            return false;
-        }
-        ++expectedIt;
-        ++actualIt;
-    }
-    return true;
-}
\ No newline at end of file
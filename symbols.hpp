@@ -1,79 +1,121 @@
 #ifndef SYMBOLS_HPP
 #define SYMBOLS_HPP
 
-#include "output.hpp"
 #include "nodes.hpp"
 #include <unordered_map>
-#include <stack>
 #include <vector>
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
 
 
-using namespace std;
-
-enum class type_t {
-    INT,
-    FLOAT,
-    STRING,
-    VOID
-};
-
 class Symbol {
 public:
-    string name;
-    type_t type; // TODO: Define or include type_t
+    // Points into the AST, which outlives the symbol table
+    std::string_view name;
+    ast::BuiltInType type;
     int offset;
+    // Definition of the symbol in the position index, or -1 when positions are not indexed
+    int definition;
 
-    Symbol(string name, type_t type, int offset);
+    Symbol(std::string_view name, ast::BuiltInType type, int offset, int definition);
     Symbol();
 };
 
+/* Marks where a scope starts in the symbol array, and the offsets to restore when it ends */
 class Scope {
 public:
-    vector<Symbol> symbols;
-    int current_negative_offset;
-    int current_positive_offset;
+    size_t first_symbol;
     int initial_positive_offset;
     int initial_negative_offset;
 
-    Scope(int initialPositiveOffset, int initialNegativeOffset);
-    int addArg(const string& name, type_t type);
-    int addVariable(const string& name, type_t type);
+    Scope(size_t firstSymbol, int initialPositiveOffset, int initialNegativeOffset);
 };
 
+/* Parameter or argument types packed four bits each, as the type plus one so that unused nibbles
+ * are zero. The first 16 types are stored inline, so signatures compare as integers */
+class Signature {
+public:
+    static constexpr int TYPES_PER_WORD = 16;
+
+    int size;
+    uint64_t head;
+    // Types past the first 16, 16 per word
+    std::vector<uint64_t> tail;
+
+    Signature();
+    void push_back(ast::BuiltInType type);
+    ast::BuiltInType operator[](int i) const;
+    // True if arguments of these types can be passed to parameters of types `params`
+    bool passableTo(const Signature& params) const;
+};
+
+/* Functions of the program. Signatures are collected with insertFunction, then freeze() builds a
+ * minimal perfect hash over the names so every lookup probes exactly one slot */
 class FunctionSymbolTable {
 public:
     class FunctionEntry {
     public:
-        string name;
-        type_t returnType;
-        shared_ptr<ast::Formals> formals; // Replace paramTypes with Formals
+        std::string name;
+        ast::BuiltInType returnType;
+        Signature params;
 
-        FunctionEntry(string name, type_t returnType, shared_ptr<ast::Formals> formals);
+        FunctionEntry(std::string name, ast::BuiltInType returnType);
+        // Parameter types as printed in errors, built on first use
+        std::vector<std::string>& printableParams() const;
+
+    private:
+        mutable std::vector<std::string> printable;
+        mutable bool printableBuilt;
     };
 
 private:
-    unordered_map<string, FunctionEntry> functionMap;
+    // After freeze(), the entry of a name is at the slot its hash selects; unused slots hold unnamed entries
+    std::vector<FunctionEntry> entries;
+    // Entry index of each name, used only while collecting signatures
+    std::unordered_map<std::string, size_t> pending;
+    // Hash seed of each bucket of names, chosen by freeze() so that no two names share a slot
+    std::vector<uint32_t> seeds;
+    bool frozen;
+
+    // Seeds tried per bucket before freeze() grows the table
+    static constexpr uint32_t MAX_SEED_ATTEMPTS = 1u << 16;
+
+    static uint64_t hash(std::string_view name, uint64_t seed);
+    bool insertEntry(FunctionEntry entry);
 
 public:
-    bool insertFunction(const string& name, type_t returnType, shared_ptr<ast::Formals> formals);
-    const FunctionEntry* lookupFunction(const string& name) const;
+    FunctionSymbolTable();
+    // Collects a signature. Returns false if the name is taken. Must be called before freeze()
+    bool insertFunction(const std::string& name, ast::BuiltInType returnType, const ast::Formals& formals);
+    bool insertFunction(const std::string& name, ast::BuiltInType returnType, const std::vector<ast::BuiltInType>& params);
+    // Builds the perfect hash; the table is immutable afterwards
+    void freeze();
+    const FunctionEntry* lookupFunction(const std::string& name) const;
+    // Checks a call with arguments of the given types, reporting an error if it is invalid
+    const FunctionEntry* validateFunctionCall(int lineno, const std::string& name, const Signature& args) const;
 };
 
+/* Symbols of all open scopes in one array, innermost scope last. Scopes are pushed and popped
+ * as markers into the array, so opening and closing a block does not allocate */
 class SymbolTable {
+private:
+    std::vector<Symbol> symbols;
+    std::vector<Scope> scopes;
+
 public:
-    stack<Scope> symbols_stack;
     int current_positive_offset;
     int current_negative_offset;
 
     SymbolTable();
     void beginScope();
     void endScope();
-    int addArg(const string& name, type_t type);
-    int addVariable(const string& name, type_t type);
-    Symbol* lookup(const string& name);
-    bool validateFunctionCall(const string& name, shared_ptr<ast::FormalsList> actualParams);
+    // Declare the name of `id`. The symbol views that name, so the identifier node must outlive the
+    // scope; taking the AST node rather than a string keeps temporaries from being passed
+    int addArg(const ast::ID& id, ast::BuiltInType type, int definition);
+    int addVariable(const ast::ID& id, ast::BuiltInType type, int definition);
+    Symbol* lookup(const std::string& name);
 };
 
 #endif // SYMBOLS_HPP
@@ -0,0 +1,267 @@
+#include "tokens.hpp"
+#include "output.hpp"
+#include "memstats.hpp"
+#include "literals.hpp"
+#include "locations.hpp"
+#include "simdlexer.hpp"
+#include "parser.tab.h"
+#include "trace.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <thread>
+
+namespace tokens {
+
+    /* TokenBuffer class */
+
+    void TokenBuffer::read(std::istream &in) {
+        memstats::TagScope tag(memstats::LEXER);
+        source.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        source.append(PADDING, '\0');
+    }
+
+    size_t TokenBuffer::length() const {
+        return source.size() - PADDING;
+    }
+
+    void TokenBuffer::push(int kind, uint32_t offset, uint32_t length, int payload) {
+        tokens.push_back({offset, length, payload, static_cast<int16_t>(kind)});
+    }
+
+    int TokenBuffer::internName(std::string_view name) {
+        auto it = nameIndices.find(name);
+        if (it != nameIndices.end()) {
+            return it->second;
+        }
+        int index = static_cast<int>(names.size());
+        names.push_back(name);
+        nameIndices.emplace(name, index);
+        return index;
+    }
+
+    void TokenBuffer::indexLines() {
+        memstats::TagScope tag(memstats::LEXER);
+        lineStarts.assign(1, 0);
+        size_t end = length();
+        for (size_t i = 0; i < end; i++) {
+            if (source[i] == '\n') {
+                lineStarts.push_back(static_cast<uint32_t>(i + 1));
+            }
+        }
+    }
+
+    /* Scanning */
+
+    // Smallest piece of source worth a thread of its own
+    static const size_t MIN_CHUNK = 64 * 1024;
+
+    // Appends the tokens, names and line starts of a piece that starts at `base` in the buffer's source
+    static void stitch(TokenBuffer &buffer, const TokenBuffer &piece, uint32_t base) {
+        std::vector<int> names(piece.names.size());
+        for (size_t i = 0; i < piece.names.size(); i++) {
+            std::string_view name = piece.names[i];
+            names[i] = buffer.internName(
+                    std::string_view(buffer.source.data() + base + (name.data() - piece.source.data()), name.size()));
+        }
+        for (Token token : piece.tokens) {
+            token.offset += base;
+            if (token.kind == ID) {
+                token.payload = names[token.payload];
+            }
+            buffer.tokens.push_back(token);
+        }
+        // The first line start of every piece but the first is the one after the previous piece's last newline
+        for (size_t i = base == 0 ? 0 : 1; i < piece.lineStarts.size(); i++) {
+            buffer.lineStarts.push_back(piece.lineStarts[i] + base);
+        }
+    }
+
+    void scan(TokenBuffer &buffer, int threads, Lexer lexer) {
+        memstats::TagScope tag(memstats::LEXER);
+        void (*scanPiece)(TokenBuffer &) = lexer == Lexer::SIMD ? simdlexer::scanSource : scanSource;
+        size_t length = buffer.length();
+        size_t pieces = std::min(static_cast<size_t>(std::max(threads, 1)), std::max<size_t>(length / MIN_CHUNK, 1));
+
+        if (pieces == 1) {
+            scanPiece(buffer);
+        } else {
+            // Pieces start after a newline. Tokens never contain one, and comments and whitespace end at
+            // it or are split into two that are both ignored, so the pieces scan to the same tokens
+            std::vector<size_t> bounds = {0};
+            for (size_t k = 1; k < pieces; k++) {
+                size_t at = std::max(k * length / pieces, bounds.back());
+                const void *newline = std::memchr(buffer.source.data() + at, '\n', length - at);
+                if (!newline) {
+                    break;
+                }
+                size_t bound = static_cast<const char *>(newline) - buffer.source.data() + 1;
+                if (bound < length) {
+                    bounds.push_back(bound);
+                }
+            }
+            bounds.push_back(length);
+
+            std::vector<TokenBuffer> parts(bounds.size() - 1);
+            std::vector<std::thread> workers;
+            for (size_t i = 0; i < parts.size(); i++) {
+                workers.emplace_back([&buffer, &parts, &bounds, scanPiece, i] {
+                    memstats::TagScope tag(memstats::LEXER);
+                    parts[i].source.assign(buffer.source, bounds[i], bounds[i + 1] - bounds[i]);
+                    parts[i].source.append(TokenBuffer::PADDING, '\0');
+                    scanPiece(parts[i]);
+                });
+            }
+            for (std::thread &worker : workers) {
+                worker.join();
+            }
+
+            size_t total = 0;
+            for (const TokenBuffer &part : parts) {
+                total += part.tokens.size();
+            }
+            buffer.tokens.reserve(total);
+            for (size_t i = 0; i < parts.size(); i++) {
+                stitch(buffer, parts[i], static_cast<uint32_t>(bounds[i]));
+            }
+        }
+
+        // Literals are interned here, in source order, so the pool is the same however the source was split
+        for (Token &token : buffer.tokens) {
+            if (token.kind == STRING) {
+                token.payload = literals::pool().intern(buffer.source.data() + token.offset, token.length);
+            }
+        }
+        TRACE_ADD(TOKENS_LEXED, buffer.tokens.size());
+    }
+
+    void dump(const TokenBuffer &buffer, std::ostream &os) {
+        for (const Token &token : buffer.tokens) {
+            auto line = std::upper_bound(buffer.lineStarts.begin(), buffer.lineStarts.end(), token.offset) - 1;
+            os << (line - buffer.lineStarts.begin() + 1) << ":" << (token.offset - *line + 1) << " " << token.kind
+               << " " << token.payload << " " << std::string_view(buffer.source.data() + token.offset, token.length)
+               << "\n";
+        }
+    }
+
+    TokenBuffer &buffer() {
+        static TokenBuffer instance;
+        return instance;
+    }
+
+    /* Parser interface */
+
+    // Index of the token next() returns, and the line it is on. Tokens are usually read in order, so the
+    // line is found by advancing from the previous token's
+    static size_t position = 0;
+    static size_t line = 0;
+
+    // Fills the location of the token at `position`
+    static void locate(YYLTYPE &location) {
+        const TokenBuffer &tokens = buffer();
+        const Token &token = tokens.tokens[position];
+        while (line + 1 < tokens.lineStarts.size() && tokens.lineStarts[line + 1] <= token.offset) {
+            line++;
+        }
+        // Tokens never contain newlines
+        location.first_line = location.last_line = static_cast<int>(line + 1);
+        location.first_column = static_cast<int>(token.offset - tokens.lineStarts[line] + 1);
+        location.last_column = location.first_column + static_cast<int>(token.length) - 1;
+        location.first_token = location.last_token = static_cast<int>(position);
+    }
+
+    int next(YYLTYPE &location) {
+        TokenBuffer &tokens = buffer();
+        if (position == tokens.tokens.size()) {
+            // A syntax error at the end of input is reported on the last line, as with yylineno
+            location.first_line = location.last_line = static_cast<int>(tokens.lineStarts.size());
+            location.first_column = location.last_column =
+                    static_cast<int>(tokens.length() - tokens.lineStarts.back() + 1);
+            location.first_token = location.last_token = static_cast<int>(position);
+            return 0;
+        }
+        const Token &token = tokens.tokens[position];
+        locate(location);
+        position++;
+
+        if (token.kind == ERROR) {
+            if (token.payload == NUM_TOO_LARGE) {
+                output::errorNumTooLarge(location.first_line, std::string(tokens.source, token.offset, token.length));
+            }
+            output::errorLex(location.first_line);
+        }
+        if (token.kind == NUM_B && token.payload > 255) {
+            output::errorByteTooLarge(location.first_line, token.payload);
+        }
+        return token.kind;
+    }
+
+    void seek(int target) {
+        const TokenBuffer &tokens = buffer();
+        position = target;
+        if (position < tokens.tokens.size()) {
+            uint32_t offset = tokens.tokens[position].offset;
+            line = std::upper_bound(tokens.lineStarts.begin(), tokens.lineStarts.end(), offset) -
+                   tokens.lineStarts.begin() - 1;
+        }
+    }
+
+    void skipBlock(YYLTYPE &location) {
+        const std::vector<Token> &tokens = buffer().tokens;
+        int depth = 1;
+        for (size_t i = position; i < tokens.size(); i++) {
+            if (tokens[i].kind == LBRACE) {
+                depth++;
+            } else if (tokens[i].kind == RBRACE && --depth == 0) {
+                seek(static_cast<int>(i));
+                return;
+            }
+        }
+        if (!tokens.empty()) {
+            seek(static_cast<int>(tokens.size()) - 1);
+            locate(location);
+            position = tokens.size();
+        }
+    }
+
+    YYLTYPE reduce(const YYLTYPE &first, const YYLTYPE &last) {
+        YYLTYPE location = {first.first_line, first.first_column, last.last_line, last.last_column,
+                            first.first_token, last.last_token};
+        locations::current = {location.first_line, location.first_column, location.last_line, location.last_column};
+        return location;
+    }
+
+    YYLTYPE reduceEmpty(const YYLTYPE &previous) {
+        YYLTYPE location = {previous.last_line, previous.last_column, previous.last_line, previous.last_column,
+                            previous.last_token + 1, previous.last_token};
+        locations::current = {location.first_line, location.first_column, location.last_line, location.last_column};
+        return location;
+    }
+
+    std::shared_ptr<ast::Exp> leaf(const YYLTYPE &location) {
+        const TokenBuffer &tokens = buffer();
+        const Token &token = tokens.tokens[location.first_token];
+        // The leaf records the token's span; the rule's span is restored for the nodes built after it
+        locations::Span rule = locations::current;
+        locations::current = {location.first_line, location.first_column, location.last_line, location.last_column};
+        std::shared_ptr<ast::Exp> node;
+        switch (token.kind) {
+            case ID: {
+                std::string_view name = tokens.names[token.payload];
+                node = std::make_shared<ast::ID>(name.data(), name.size());
+                break;
+            }
+            case NUM:
+                node = std::make_shared<ast::Num>(token.payload);
+                break;
+            case NUM_B:
+                node = std::make_shared<ast::NumB>(token.payload);
+                break;
+            default:
+                node = std::make_shared<ast::String>(token.payload);
+                break;
+        }
+        locations::current = rule;
+        return node;
+    }
+}
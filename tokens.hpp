@@ -0,0 +1,123 @@
+#ifndef TOKENS_HPP
+#define TOKENS_HPP
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "nodes.hpp"
+
+/* Location of a grammar symbol: its source span and the range of tokens it covers */
+struct YYLTYPE {
+    int first_line;
+    int first_column;
+    int last_line;
+    int last_column;
+    // Index of the first and last token in tokens::buffer(); first is last + 1 for empty rules
+    int first_token;
+    int last_token;
+};
+// Not marked trivial: bison would then initialize yylloc with only the four span fields. The parser never
+// relocates its stacks by memcpy anyway, since the semantic values are shared pointers
+#define YYLTYPE_IS_DECLARED 1
+
+namespace tokens {
+
+    // Kind of a token the scanner could not accept; reported when the parser reaches it
+    constexpr int ERROR = -1;
+
+    /* Payload of ERROR tokens */
+    enum ErrorKind {
+        LEXICAL,      // No rule matches
+        NUM_TOO_LARGE // The literal does not fit in an int
+    };
+
+    /* A scanned token */
+    struct Token {
+        uint32_t offset;
+        uint32_t length;
+        // NUM and NUM_B: the value, ID: the name index, STRING: the literal pool index, ERROR: the ErrorKind
+        int32_t payload;
+        int16_t kind;
+    };
+
+    /* The program scanned into tokens ahead of parsing */
+    class TokenBuffer {
+    private:
+        std::unordered_map<std::string_view, int> nameIndices;
+
+    public:
+        // NULs after the source: flex needs two at the end of an in-memory buffer, and the SIMD
+        // scanner reads whole 16-byte blocks
+        static constexpr size_t PADDING = 32;
+
+        // Source text, followed by PADDING NULs
+        std::string source;
+        std::vector<Token> tokens;
+        // Distinct identifiers, viewing the source
+        std::vector<std::string_view> names;
+        // Offset of the first character of every line
+        std::vector<uint32_t> lineStarts;
+
+        // Reads the whole stream as the source
+        void read(std::istream &in);
+
+        // Length of the source, without the padding
+        size_t length() const;
+
+        void push(int kind, uint32_t offset, uint32_t length, int payload);
+
+        // Returns the index of the name, adding it if new
+        int internName(std::string_view name);
+
+        // Fills lineStarts from the source
+        void indexLines();
+    };
+
+    // Buffer of the program being compiled
+    TokenBuffer &buffer();
+
+    // Scans the buffer's source in place with the flex scanner (see scanner.lex). Names are interned
+    // into the buffer; string literals are left for scan() to intern
+    void scanSource(TokenBuffer &buffer);
+
+    /* Implementations of the scanning stage */
+    enum class Lexer {
+        FLEX, // scanner.lex
+        SIMD  // simdlexer.hpp
+    };
+
+    // Scans the source of the buffer into its tokens. Large sources are split at newlines, which
+    // no token spans, and the pieces are scanned on up to `threads` threads
+    void scan(TokenBuffer &buffer, int threads, Lexer lexer);
+
+    // Prints one line per token: line, column, kind, payload and text
+    void dump(const TokenBuffer &buffer, std::ostream &os);
+
+    // Hands the next token of buffer() to the parser, reporting the error of ERROR tokens
+    int next(YYLTYPE &location);
+
+    // Makes next() continue from the token at the given index
+    void seek(int position);
+
+    // Skips the tokens up to the brace closing the block whose opening brace was just read, without
+    // reporting their errors. The closing brace is the next token next() returns; if the block is never
+    // closed, next() returns the end of input and the location is set to the last token's
+    void skipBlock(YYLTYPE &location);
+
+    // Location of a rule spanning the symbols from `first` to `last`. Published as locations::current, so the
+    // nodes built for the rule record its span
+    YYLTYPE reduce(const YYLTYPE &first, const YYLTYPE &last);
+
+    // Location of an empty rule, placed at the end of the symbol before it
+    YYLTYPE reduceEmpty(const YYLTYPE &previous);
+
+    // Builds the node of an ID, NUM, NUM_B or STRING token
+    std::shared_ptr<ast::Exp> leaf(const YYLTYPE &location);
+}
+
+#endif //TOKENS_HPP
@@ -0,0 +1,103 @@
+#include "trace.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+namespace trace {
+
+    bool enabled = false;
+
+    long long counters[NUM_COUNTERS] = {};
+
+    /* Recorded data */
+
+    struct Event {
+        std::string name;
+        long long start;
+        long long duration;
+        // Counter values when the phase ended
+        long long counters[NUM_COUNTERS];
+    };
+
+    static const char *counterNames[NUM_COUNTERS] = {
+            "tokens lexed", "nodes allocated", "symbol lookups", "scopes pushed", "bytes printed"
+    };
+
+    static std::string outputPath;
+    static std::vector<Event> events;
+    static std::vector<size_t> open;
+    static std::chrono::steady_clock::time_point origin;
+
+    /* Helper functions */
+
+    static long long now() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin)
+                .count();
+    }
+
+    static void writeString(std::ostream &os, const std::string &str) {
+        os << '"';
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                os << '\\';
+            }
+            os << c;
+        }
+        os << '"';
+    }
+
+    // Closes phases left open by an early exit and writes the trace file
+    static void flush() {
+        while (!open.empty()) {
+            end();
+        }
+
+        std::ofstream os(outputPath);
+        os << "{\"traceEvents\":[" << std::endl;
+        bool first = true;
+        for (const Event &event : events) {
+            os << (first ? "" : ",\n") << "{\"name\":";
+            writeString(os, event.name);
+            os << ",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << event.start << ",\"dur\":" << event.duration << "}";
+            first = false;
+
+            os << ",\n{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":" << event.start + event.duration
+               << ",\"args\":{";
+            for (int i = 0; i < NUM_COUNTERS; ++i) {
+                os << (i ? "," : "") << '"' << counterNames[i] << "\":" << event.counters[i];
+            }
+            os << "}}";
+        }
+        os << std::endl << "]}" << std::endl;
+    }
+
+    /* Recording */
+
+    void start(const std::string &path) {
+        if (enabled) {
+            return;
+        }
+        enabled = true;
+        outputPath = path;
+        origin = std::chrono::steady_clock::now();
+        std::atexit(flush);
+    }
+
+    void begin(const char *name) {
+        open.push_back(events.size());
+        events.push_back(Event{name, now(), 0, {}});
+    }
+
+    void end() {
+        if (open.empty()) {
+            return;
+        }
+        Event &event = events[open.back()];
+        open.pop_back();
+        event.duration = now() - event.start;
+        for (int i = 0; i < NUM_COUNTERS; ++i) {
+            event.counters[i] = counters[i];
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <string>
+
+/* Phase timers and event counters, written in Chrome trace-event format (chrome://tracing, Perfetto).
+ * Building with -DFANC_NO_TRACE compiles every TRACE_* macro out.
+ */
+namespace trace {
+
+    /* Counters bumped from the hot paths of the front end */
+    enum Counter {
+        TOKENS_LEXED,
+        NODES_ALLOCATED,
+        SYMBOL_LOOKUPS,
+        SCOPES_PUSHED,
+        BYTES_PRINTED,
+        NUM_COUNTERS
+    };
+
+    // True once start() was called
+    extern bool enabled;
+
+    extern long long counters[NUM_COUNTERS];
+
+    // Starts recording; the trace is written to the given path when the program exits
+    void start(const std::string &path);
+
+    // Marks the beginning and end of a named phase. Phases nest
+    void begin(const char *name);
+
+    void end();
+
+    /* Times the enclosing C++ scope as a phase */
+    class Scope {
+    public:
+        explicit Scope(const char *name) {
+            if (enabled) {
+                begin(name);
+            }
+        }
+
+        ~Scope() {
+            if (enabled) {
+                end();
+            }
+        }
+
+        Scope(const Scope &) = delete;
+
+        Scope &operator=(const Scope &) = delete;
+    };
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#ifndef FANC_NO_TRACE
+#define TRACE_SCOPE(name) trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_ADD(counter, n) (trace::counters[trace::counter] += (n))
+#else
+#define TRACE_SCOPE(name) ((void) 0)
+#define TRACE_ADD(counter, n) ((void) 0)
+#endif
+
+#define TRACE_COUNT(counter) TRACE_ADD(counter, 1)
+
+#endif //TRACE_HPP
@@ -0,0 +1,129 @@
+#ifndef TYPES_HPP
+#define TYPES_HPP
+
+#include <array>
+#include "nodes.hpp"
+
+/* The type rules of FanC as compile-time tables indexed by ast::BuiltInType, so the checker
+ * looks a rule up instead of branching on the operand types */
+namespace types {
+
+    // Number of built-in types, the size of every table dimension
+    constexpr int NUM_TYPES = ast::BuiltInType::STRING + 1;
+
+    template<typename T>
+    using Table = std::array<std::array<T, NUM_TYPES>, NUM_TYPES>;
+
+    constexpr std::array<const char *, NUM_TYPES> NAMES = {"void", "bool", "byte", "int", "string"};
+
+    constexpr bool isNumeric(ast::BuiltInType type) {
+        return type == ast::BuiltInType::BYTE || type == ast::BuiltInType::INT;
+    }
+
+    namespace detail {
+        constexpr Table<bool> makeAssignable() {
+            Table<bool> table{};
+            for (int to = 0; to < NUM_TYPES; to++) {
+                for (int from = 0; from < NUM_TYPES; from++) {
+                    table[to][from] = to != ast::BuiltInType::VOID &&
+                                      (to == from || (to == ast::BuiltInType::INT && from == ast::BuiltInType::BYTE));
+                }
+            }
+            return table;
+        }
+
+        // Pairs of numeric types, the operands of casts and comparisons
+        constexpr Table<bool> makeNumericPairs() {
+            Table<bool> table{};
+            for (int to = 0; to < NUM_TYPES; to++) {
+                for (int from = 0; from < NUM_TYPES; from++) {
+                    table[to][from] = isNumeric(static_cast<ast::BuiltInType>(to)) &&
+                                      isNumeric(static_cast<ast::BuiltInType>(from));
+                }
+            }
+            return table;
+        }
+
+        constexpr Table<ast::BuiltInType> makeBinOpResult() {
+            Table<ast::BuiltInType> table{};
+            for (int left = 0; left < NUM_TYPES; left++) {
+                for (int right = 0; right < NUM_TYPES; right++) {
+                    bool numeric = isNumeric(static_cast<ast::BuiltInType>(left)) &&
+                                   isNumeric(static_cast<ast::BuiltInType>(right));
+                    bool bytes = left == ast::BuiltInType::BYTE && right == ast::BuiltInType::BYTE;
+                    table[left][right] = !numeric ? ast::BuiltInType::VOID
+                                                  : bytes ? ast::BuiltInType::BYTE : ast::BuiltInType::INT;
+                }
+            }
+            return table;
+        }
+    }
+
+    // ASSIGNABLE[to][from]: a value of type `from` can be assigned, passed or returned as `to`
+    constexpr Table<bool> ASSIGNABLE = detail::makeAssignable();
+
+    // CASTABLE[to][from]: an explicit cast from `from` to `to` is legal
+    constexpr Table<bool> CASTABLE = detail::makeNumericPairs();
+
+    // BINOP_RESULT[left][right]: type of an arithmetic operation, or VOID if the operands are illegal.
+    // Bytes stay bytes only when both operands are bytes; otherwise the result is promoted to int
+    constexpr Table<ast::BuiltInType> BINOP_RESULT = detail::makeBinOpResult();
+
+    // RELOP_LEGAL[left][right]: the operands can be compared
+    constexpr Table<bool> RELOP_LEGAL = detail::makeNumericPairs();
+
+    // Name of the type as printed in the output
+    constexpr const char *name(ast::BuiltInType type) {
+        return NAMES[type];
+    }
+
+    constexpr bool assignable(ast::BuiltInType to, ast::BuiltInType from) {
+        return ASSIGNABLE[to][from];
+    }
+
+    constexpr bool castable(ast::BuiltInType to, ast::BuiltInType from) {
+        return CASTABLE[to][from];
+    }
+
+    constexpr ast::BuiltInType binOpResult(ast::BuiltInType left, ast::BuiltInType right) {
+        return BINOP_RESULT[left][right];
+    }
+
+    constexpr bool relOpLegal(ast::BuiltInType left, ast::BuiltInType right) {
+        return RELOP_LEGAL[left][right];
+    }
+
+    /* Tests of the tables */
+
+    static_assert(assignable(ast::BuiltInType::INT, ast::BuiltInType::INT), "int = int");
+    static_assert(assignable(ast::BuiltInType::INT, ast::BuiltInType::BYTE), "bytes widen to int");
+    static_assert(!assignable(ast::BuiltInType::BYTE, ast::BuiltInType::INT), "ints need a cast to become bytes");
+    static_assert(assignable(ast::BuiltInType::BOOL, ast::BuiltInType::BOOL), "bool = bool");
+    static_assert(assignable(ast::BuiltInType::STRING, ast::BuiltInType::STRING), "string = string");
+    static_assert(!assignable(ast::BuiltInType::INT, ast::BuiltInType::BOOL), "bools are not numbers");
+    static_assert(!assignable(ast::BuiltInType::BOOL, ast::BuiltInType::INT), "numbers are not bools");
+    static_assert(!assignable(ast::BuiltInType::VOID, ast::BuiltInType::VOID), "nothing holds void");
+
+    static_assert(castable(ast::BuiltInType::BYTE, ast::BuiltInType::INT), "int to byte");
+    static_assert(castable(ast::BuiltInType::INT, ast::BuiltInType::BYTE), "byte to int");
+    static_assert(castable(ast::BuiltInType::INT, ast::BuiltInType::INT), "int to int");
+    static_assert(!castable(ast::BuiltInType::BOOL, ast::BuiltInType::INT), "int to bool");
+    static_assert(!castable(ast::BuiltInType::INT, ast::BuiltInType::STRING), "string to int");
+
+    static_assert(binOpResult(ast::BuiltInType::BYTE, ast::BuiltInType::BYTE) == ast::BuiltInType::BYTE, "byte op byte");
+    static_assert(binOpResult(ast::BuiltInType::BYTE, ast::BuiltInType::INT) == ast::BuiltInType::INT, "byte op int");
+    static_assert(binOpResult(ast::BuiltInType::INT, ast::BuiltInType::BYTE) == ast::BuiltInType::INT, "int op byte");
+    static_assert(binOpResult(ast::BuiltInType::INT, ast::BuiltInType::INT) == ast::BuiltInType::INT, "int op int");
+    static_assert(binOpResult(ast::BuiltInType::BOOL, ast::BuiltInType::INT) == ast::BuiltInType::VOID, "bool op int");
+    static_assert(binOpResult(ast::BuiltInType::STRING, ast::BuiltInType::STRING) == ast::BuiltInType::VOID,
+                  "string op string");
+
+    static_assert(relOpLegal(ast::BuiltInType::BYTE, ast::BuiltInType::INT), "byte relop int");
+    static_assert(!relOpLegal(ast::BuiltInType::BOOL, ast::BuiltInType::BOOL), "bool relop bool");
+    static_assert(!relOpLegal(ast::BuiltInType::STRING, ast::BuiltInType::INT), "string relop int");
+
+    static_assert(name(ast::BuiltInType::VOID)[0] == 'v' && name(ast::BuiltInType::STRING)[0] == 's',
+                  "names follow the enum order");
+}
+
+#endif //TYPES_HPP
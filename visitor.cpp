@@ -2,421 +2,349 @@
 // Created by Omer Oz on 19/12/2024.
 //
 
-#include "visitor.hpp"
+#include "semantic.hpp"
 
 #include "output.hpp"
+#include "interfaces.hpp"
+#include "types.hpp"
 #include <iostream>
 
 namespace output {
-    static const std::string child_prefix = "├──";
-    static const std::string last_child_prefix = "└──";
-    static const std::string child_indent = "│   ";
-    static const std::string last_child_indent = "    ";
-
-    /* Helper functions */
-
-    static std::string toString(ast::BuiltInType type) {
-        switch (type) {
-            case ast::BuiltInType::INT:
-                return "int";
-            case ast::BuiltInType::BOOL:
-                return "bool";
-            case ast::BuiltInType::BYTE:
-                return "byte";
-            case ast::BuiltInType::VOID:
-                return "void";
-            case ast::BuiltInType::STRING:
-                return "string";
-            default:
-                return "unknown";
+
+    void populateFunctionTable(FunctionSymbolTable &funcTab, ScopePrinter &printer,
+                               const std::vector<interfaces::Function> *imports, const ast::Funcs &program) {
+        funcTab.insertFunction("print", ast::BuiltInType::VOID, {ast::BuiltInType::STRING});
+        funcTab.insertFunction("printi", ast::BuiltInType::VOID, {ast::BuiltInType::INT});
+        printer.emitFunc("print", ast::BuiltInType::VOID, {ast::BuiltInType::STRING});
+        printer.emitFunc("printi", ast::BuiltInType::VOID, {ast::BuiltInType::INT});
+        if (imports) {
+            for (const auto &function : *imports) {
+                if (!funcTab.insertFunction(function.name, function.returnType, function.params)) {
+                    output::errorImportConflict(function.name);
+                }
+            }
         }
+        for (const auto &func : program.funcs) {
+            if (!funcTab.insertFunction(func->id->value, func->return_type->type, *func->formals)) {
+                output::errorDef(func->line(), func->id->value);
+            }
+            std::vector<ast::BuiltInType> params;
+            for (const auto &formal : func->formals->formals) {
+                params.push_back(formal->type->type);
+            }
+            printer.emitFunc(func->id->value, func->return_type->type, params);
+        }
+        funcTab.freeze();
     }
+
     /* SemanticVisitor implementation */
 
-    SemanticVisitor::SemanticVisitor() : indents({last_child_indent}), prefixes({last_child_prefix}) {}
+    SemanticVisitor::SemanticVisitor()
+            : imports(nullptr), expType(ast::BuiltInType::VOID), returnType(ast::BuiltInType::VOID), loopDepth(0) {}
 
-    void SemanticVisitor::print_indented(const std::string &str) {
-        for (auto it = indents.begin(); it != indents.end() - 1; ++it) {
-            std::cout << *it;
-        }
-        std::cout << prefixes.back() << str << std::endl;
+    ScopePrinter &SemanticVisitor::scopes() {
+        return printer;
     }
 
-    void SemanticVisitor::enter_child() {
-        indents.emplace_back(child_indent);
-        prefixes.emplace_back(child_prefix);
+    void SemanticVisitor::importFunctions(const std::vector<interfaces::Function> *functions) {
+        imports = functions;
     }
 
-    void SemanticVisitor::enter_last_child() {
-        indents.emplace_back(last_child_indent);
-        prefixes.emplace_back(last_child_prefix);
+    void SemanticVisitor::indexPositions(posindex::Index &index) {
+        positions = posindex::Builder(index);
+    }
+
+    ast::BuiltInType SemanticVisitor::typeOf(ast::Exp &exp) {
+        exp.accept(*this);
+        return expType;
+    }
+
+    void SemanticVisitor::visitScoped(ast::Statement &statement) {
+        printer.beginScope();
+        symTab.beginScope();
+        statement.accept(*this);
+        printer.endScope();
+        symTab.endScope();
     }
 
-    void SemanticVisitor::leave_child() {
-        indents.pop_back();
-        prefixes.pop_back();
+    void SemanticVisitor::checkUnused(int lineno, const std::string &name) {
+        if (symTab.lookup(name) != nullptr || funcTab.lookupFunction(name) != nullptr) {
+            output::errorDef(lineno, name);
+        }
     }
 
     void SemanticVisitor::visit(ast::Num &node) {
-        print_indented("Num: " + std::to_string(node.value));
+        positions.openNode(node);
+        expType = ast::BuiltInType::INT;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::NumB &node) {
-        print_indented("NumB: " + std::to_string(node.value));
+        positions.openNode(node);
+        expType = ast::BuiltInType::BYTE;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::String &node) {
-        print_indented("String: " + node.value);
+        positions.openNode(node);
+        expType = ast::BuiltInType::STRING;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::Bool &node) {
-        print_indented("Bool: " + std::string((node.value ? "true" : "false")));
+        positions.openNode(node);
+        expType = ast::BuiltInType::BOOL;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::ID &node) {
-        print_indented("ID: " + node.value);
+        const Symbol *symbol = symTab.lookup(node.value);
+        if (symbol == nullptr) {
+            if (funcTab.lookupFunction(node.value) != nullptr) {
+                output::errorDefAsFunc(node.line(), node.value);
+            }
+            output::errorUndef(node.line(), node.value);
+        }
+        positions.variable(node, *symbol);
+        expType = symbol->type;
     }
 
     void SemanticVisitor::visit(ast::BinOp &node) {
-        std::string op;
-
-        switch (node.op) {
-            case ast::BinOpType::ADD:
-                op = "+";
-                break;
-            case ast::BinOpType::SUB:
-                op = "-";
-                break;
-            case ast::BinOpType::MUL:
-                op = "*";
-                break;
-            case ast::BinOpType::DIV:
-                op = "/";
-                break;
+        positions.openNode(node);
+        ast::BuiltInType left = typeOf(*node.left);
+        ast::BuiltInType right = typeOf(*node.right);
+        expType = types::binOpResult(left, right);
+        if (expType == ast::BuiltInType::VOID) {
+            output::errorMismatch(node.line());
         }
-
-        print_indented("BinOp: " + op);
-
-        enter_child();
-        node.left->accept(*this);
-        leave_child();
-
-        enter_last_child();
-        node.right->accept(*this);
-        leave_child();
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::RelOp &node) {
-        std::string op;
-
-        switch (node.op) {
-            case ast::RelOpType::EQ:
-                op = "==";
-                break;
-            case ast::RelOpType::NE:
-                op = "!=";
-                break;
-            case ast::RelOpType::LT:
-                op = "<";
-                break;
-            case ast::RelOpType::LE:
-                op = "<=";
-                break;
-            case ast::RelOpType::GT:
-                op = ">";
-                break;
-            case ast::RelOpType::GE:
-                op = ">=";
-                break;
+        positions.openNode(node);
+        ast::BuiltInType left = typeOf(*node.left);
+        ast::BuiltInType right = typeOf(*node.right);
+        if (!types::relOpLegal(left, right)) {
+            output::errorMismatch(node.line());
         }
-
-        print_indented("RelOp: " + op);
-
-        enter_child();
-        node.left->accept(*this);
-        leave_child();
-
-
-        enter_last_child();
-        node.right->accept(*this);
-        leave_child();
+        expType = ast::BuiltInType::BOOL;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::Type &node) {
-        print_indented("Type: " + toString(node.type));
+        positions.typeName(node);
+        expType = node.type;
     }
 
     void SemanticVisitor::visit(ast::Cast &node) {
-        print_indented("Cast");
-
-        enter_child();
-        node.exp->accept(*this);
-        leave_child();
-
-        enter_last_child();
-        node.target_type->accept(*this);
-        leave_child();
+        positions.openNode(node);
+        positions.typeName(*node.target_type);
+        ast::BuiltInType from = typeOf(*node.exp);
+        if (!types::castable(node.target_type->type, from)) {
+            output::errorMismatch(node.line());
+        }
+        expType = node.target_type->type;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::Not &node) {
-        print_indented("Not");
-
-        enter_last_child();
-        node.exp->accept(*this);
-        leave_child();
+        positions.openNode(node);
+        if (typeOf(*node.exp) != ast::BuiltInType::BOOL) {
+            output::errorMismatch(node.line());
+        }
+        expType = ast::BuiltInType::BOOL;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::And &node) {
-        print_indented("And");
-
-        enter_child();
-        node.left->accept(*this);
-        leave_child();
-
-        enter_last_child();
-        node.right->accept(*this);
-        leave_child();
+        positions.openNode(node);
+        if (typeOf(*node.left) != ast::BuiltInType::BOOL || typeOf(*node.right) != ast::BuiltInType::BOOL) {
+            output::errorMismatch(node.line());
+        }
+        expType = ast::BuiltInType::BOOL;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::Or &node) {
-        print_indented("Or");
-
-        enter_child();
-        node.left->accept(*this);
-        leave_child();
-
-        enter_last_child();
-        node.right->accept(*this);
-        leave_child();
+        positions.openNode(node);
+        if (typeOf(*node.left) != ast::BuiltInType::BOOL || typeOf(*node.right) != ast::BuiltInType::BOOL) {
+            output::errorMismatch(node.line());
+        }
+        expType = ast::BuiltInType::BOOL;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::ExpList &node) {
-        print_indented("ExpList");
-
-        for (auto it = node.exps.rbegin(); it != node.exps.rend(); ++it) {
-            if (it != node.exps.rend() - 1) {
-                enter_child();
-            } else {
-                enter_last_child();
-            }
-            (*it)->accept(*this);
-            leave_child();
+        positions.openList();
+        for (const auto &exp : node.exps) {
+            exp->accept(*this);
         }
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::Call &node) {
-        //print_indented("Call");
-        printer.beginScope();
-        symTab.beginScope();
-
-        enter_child();
-        node.func_id->accept(*this);
-        leave_child();
-
-        enter_last_child();
-        node.args->accept(*this);
-        leave_child();
-        printer.endScope();
-        symTab.endScope();
+        const std::string &name = node.func_id->value;
+        positions.openNode(node);
+        // The name comes before the arguments in the source, so it is indexed before the call is checked
+        positions.function(*node.func_id, funcTab, false);
+        Signature args;
+        positions.openList();
+        for (const auto &exp : node.args->exps) {
+            args.push_back(typeOf(*exp));
+        }
+        positions.close();
+        if (funcTab.lookupFunction(name) == nullptr && symTab.lookup(name) != nullptr) {
+            output::errorDefAsVar(node.line(), name);
+        }
+        expType = funcTab.validateFunctionCall(node.line(), name, args)->returnType;
+        positions.close(expType);
     }
 
     void SemanticVisitor::visit(ast::Statements &node) {
-        //print_indented("Statements");
         printer.beginScope();
         symTab.beginScope();
-
-        for (auto it = node.statements.begin(); it != node.statements.end(); ++it) {
-            if (it != node.statements.end() - 1) {
-                enter_child();
-            } else {
-                enter_last_child();
-            }
-            (*it)->accept(*this);
-            leave_child();
+        positions.openList();
+        for (const auto &statement : node.statements) {
+            statement->accept(*this);
         }
+        positions.close();
         printer.endScope();
         symTab.endScope();
     }
 
     void SemanticVisitor::visit(ast::Break &node) {
-        print_indented("Break");
+        if (loopDepth == 0) {
+            output::errorUnexpectedBreak(node.line());
+        }
+        positions.openNode(node);
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::Continue &node) {
-        print_indented("Continue");
+        if (loopDepth == 0) {
+            output::errorUnexpectedContinue(node.line());
+        }
+        positions.openNode(node);
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::Return &node) {
-        print_indented("Return");
-
+        positions.openNode(node);
         if (node.exp) {
-            enter_last_child();
-            node.exp->accept(*this);
-            leave_child();
+            if (!types::assignable(returnType, typeOf(*node.exp))) {
+                output::errorMismatch(node.line());
+            }
+        } else if (returnType != ast::BuiltInType::VOID) {
+            output::errorMismatch(node.line());
         }
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::If &node) {
-        //print_indented("If");
-        printer.beginScope();
-        symTab.beginScope();
-
-        enter_child();
-        node.condition->accept(*this);
-        leave_child();
-
-        if (node.otherwise) {
-            enter_child();
-        } else {
-            enter_last_child();
+        positions.openNode(node);
+        if (typeOf(*node.condition) != ast::BuiltInType::BOOL) {
+            output::errorMismatch(node.condition->line());
         }
-        node.then->accept(*this);
-        leave_child();
-
+        visitScoped(*node.then);
         if (node.otherwise) {
-            enter_last_child();
-            node.otherwise->accept(*this);
-            leave_child();
+            visitScoped(*node.otherwise);
         }
-        printer.endScope();
-        symTab.endScope();
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::While &node) {
-        //print_indented("While");
-        printer.beginScope();
-        symTab.beginScope();
-        enter_child();
-        node.condition->accept(*this);
-        leave_child();
-
-        enter_last_child();
-        node.body->accept(*this);
-        leave_child();
-        printer.endScope();
-        symTab.endScope();
+        positions.openNode(node);
+        if (typeOf(*node.condition) != ast::BuiltInType::BOOL) {
+            output::errorMismatch(node.condition->line());
+        }
+        loopDepth++;
+        visitScoped(*node.body);
+        loopDepth--;
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::VarDecl &node) {
-        print_indented("VarDecl");
-
-        enter_child();
-        node.id->accept(*this);
-        leave_child();
-
-        if (node.init_exp) {
-            enter_child();
-        } else {
-            enter_last_child();
-        }
-        node.type->accept(*this);
-        leave_child();
-
-        if (node.init_exp) {
-            enter_last_child();
-            node.init_exp->accept(*this);
-            leave_child();
+        positions.openNode(node);
+        positions.typeName(*node.type);
+        int definition = positions.declareVariable(*node.id, node.type->type);
+        // The initializer is checked before the new name becomes visible
+        if (node.init_exp && !types::assignable(node.type->type, typeOf(*node.init_exp))) {
+            output::errorMismatch(node.line());
         }
+        checkUnused(node.id->line(), node.id->value);
+        int offset = symTab.addVariable(*node.id, node.type->type, definition);
+        // With --pack-frames, the offset chosen by the frame layout is printed instead
+        printer.emitVar(node, node.id->value, node.type->type, offset);
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::Assign &node) {
-        print_indented("Assign");
-
-        enter_child();
-        node.id->accept(*this);
-        leave_child();
-        if (symTab.lookup(node.id)== nullptr){
-            output::errorUndef(node.line,node.id); //TODO: line?
+        positions.openNode(node);
+        const Symbol *symbol = symTab.lookup(node.id->value);
+        if (symbol == nullptr) {
+            if (funcTab.lookupFunction(node.id->value) != nullptr) {
+                output::errorDefAsFunc(node.id->line(), node.id->value);
+            }
+            output::errorUndef(node.id->line(), node.id->value);
         }
-    }
-
-        enter_last_child();
-        node.exp->accept(*this);
-        leave_child();
+        positions.variable(*node.id, *symbol);
+        if (!types::assignable(symbol->type, typeOf(*node.exp))) {
+            output::errorMismatch(node.line());
+        }
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::Formal &node) {
-        print_indented("Formal");
-
-        enter_child();
-        node.id->accept(*this);
-        leave_child();
-
-        if (symTab.lookup(node.id)!= nullptr){
-            output::errorDef(node.line,node.id);
-        }
-        if(funcTab.lookupFunction(node.id)!= nullptr){
-            output::errorDef(node.line,node.id); //TODO: should raise this error?
-        }
-
-        enter_last_child();
-        node.type->accept(*this);
-        leave_child();
-
-        //int offset= symTab.symbols_stack.top().addParam(node.id,node.type); //TODO:  addparam returns offset
-        //emitvar()
+        positions.openNode(node);
+        positions.typeName(*node.type);
+        int definition = positions.declareVariable(*node.id, node.type->type);
+        checkUnused(node.id->line(), node.id->value);
+        int offset = symTab.addArg(*node.id, node.type->type, definition);
+        printer.emitVar(node, node.id->value, node.type->type, offset);
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::Formals &node) {
-        //print_indented("Formals");
-
-        for (auto it = node.formals.rbegin(); it != node.formals.rend(); ++it) {
-            if (it != node.formals.rend() - 1) {
-                enter_child();
-            } else {
-                enter_last_child();
-            }
-            (*it)->accept(*this);
-            leave_child();
+        positions.openList();
+        for (const auto &formal : node.formals) {
+            formal->accept(*this);
         }
+        positions.close();
     }
 
     void SemanticVisitor::visit(ast::FuncDecl &node) {
-        //print_indented("FuncDecl");
-
-        enter_child();
-        node.id->accept(*this);
-        leave_child();
-
-        enter_child();
-        node.return_type->accept(*this);
-        leave_child();
-
-        enter_child();
+        // Parameters and the top-level statements of the body share the function's scope
+        printer.beginScope();
+        symTab.beginScope();
+        returnType = node.return_type->type;
+        positions.openNode(node);
+        positions.typeName(*node.return_type);
+        positions.function(*node.id, funcTab, true);
         node.formals->accept(*this);
-        leave_child();
-
-        if (!(funcTab.insertFunction(node.id,node.return_type,node.formals))){
-            output::errorDef(node.line,node.id);
+        positions.openList();
+        for (const auto &statement : node.body->statements) {
+            statement->accept(*this);
         }
-        std::vector<std::shared_ptr<Type>> types;
-        types.reserve(node.formals.size());
-
-        for (const auto &formal :node.formals) {
-            if (formal && formal->type) {
-                types.push_back(formal->type);
-            }
-        }
-        printer.emitFunc(node.id,node.return_type,types);
-
-        enter_last_child();
-        node.body->accept(*this);
-        leave_child();
+        positions.close();
+        positions.close();
+        printer.endScope();
+        symTab.endScope();
     }
 
     void SemanticVisitor::visit(ast::Funcs &node) {
-        //print_indented("Funcs");
+        // Functions may be called before they are declared, so collect every signature up front
+        populateFunctionTable(funcTab, printer, imports, node);
 
-        for (auto it = node.funcs.begin(); it != node.funcs.end(); ++it) {
-            if (it != node.funcs.end() - 1) {
-                enter_child();
-            } else {
-                enter_last_child();
-            }
-            (*it)->accept(*this);
-            leave_child();
+        positions.openList();
+        for (const auto &func : node.funcs) {
+            func->accept(*this);
         }
-    }
-
-
+        positions.close();
+        positions.finish();
 
+        const FunctionSymbolTable::FunctionEntry *main = funcTab.lookupFunction("main");
+        if (!main || main->returnType != ast::BuiltInType::VOID || main->params.size != 0) {
+            output::errorMainMissing();
+        }
+    }
+}
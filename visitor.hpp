@@ -1,6 +1,5 @@
 #ifndef VISITOR_HPP
 #define VISITOR_HPP
-#include "symbols.cpp"
 
 namespace ast {
     class Num;
@@ -86,78 +85,4 @@ public:
     virtual void visit(ast::Funcs &node) = 0;
 };
 
-class SemanticVisitor : public Visitor {
-private:
-    std::vector<std::string> indents;
-    std::vector<std::string> prefixes;
-    ScopePrinter printer;
-    SymbolTable symTab;
-    FunctionSymbolTable funcTab;
-    /* Helper function to print a string with the current indentation */
-    void print_indented(const std::string &str);
-
-    /* Functions to manage the indentation level */
-    void enter_child();
-
-    void enter_last_child();
-
-    void leave_child();
-
-public:
-    SemanticVisitor();
-
-    void visit(ast::Num &node) override;
-
-    void visit(ast::NumB &node) override;
-
-    void visit(ast::String &node) override;
-
-    void visit(ast::Bool &node) override;
-
-    void visit(ast::ID &node) override;
-
-    void visit(ast::BinOp &node) override;
-
-    void visit(ast::RelOp &node) override;
-
-    void visit(ast::Not &node) override;
-
-    void visit(ast::And &node) override;
-
-    void visit(ast::Or &node) override;
-
-    void visit(ast::Type &node) override;
-
-    void visit(ast::Cast &node) override;
-
-    void visit(ast::ExpList &node) override;
-
-    void visit(ast::Call &node) override;
-
-    void visit(ast::Statements &node) override;
-
-    void visit(ast::Break &node) override;
-
-    void visit(ast::Continue &node) override;
-
-    void visit(ast::Return &node) override;
-
-    void visit(ast::If &node) override;
-
-    void visit(ast::While &node) override;
-
-    void visit(ast::VarDecl &node) override;
-
-    void visit(ast::Assign &node) override;
-
-    void visit(ast::Formal &node) override;
-
-    void visit(ast::Formals &node) override;
-
-    void visit(ast::FuncDecl &node) override;
-
-    void visit(ast::Funcs &node) override;
-};
-}
-
 #endif //VISITOR_HPP